@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "parallel.h"
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory mapping of a whole file. text() is empty if the file could not be opened or is empty.
+struct MappedFile {
+    MappedFile(const char* path) {
+#if defined(_WIN32)
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) return;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) return;
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr) return;
+        data = static_cast<const char*>(view);
+        size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        fd = open(path, O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) return;
+        void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) return;
+        madvise(view, st.st_size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(view);
+        size = static_cast<size_t>(st.st_size);
+#endif
+    }
+
+    ~MappedFile() {
+#if defined(_WIN32)
+        if (data != nullptr) UnmapViewOfFile(data);
+        if (mapping != nullptr) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (data != nullptr) munmap(const_cast<char*>(data), size);
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view text() const {
+        return { data, size };
+    }
+
+    const char* data = nullptr;
+    size_t size = 0;
+
+private:
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+// Splits text into chunkCount pieces of roughly equal size whose boundaries fall just after a '\n', so that no
+// line straddles two chunks. Returns chunkCount + 1 offsets; chunk i is [bounds[i], bounds[i + 1]).
+inline std::vector<size_t> splitAtNewlines(std::string_view text, size_t chunkCount) {
+    std::vector<size_t> bounds(chunkCount + 1);
+    bounds[chunkCount] = text.size();
+    for (size_t i = 1; i < chunkCount; i++) {
+        size_t pos = std::max(text.size() * i / chunkCount, bounds[i - 1]);
+        while (pos > 0 && pos < text.size() && text[pos - 1] != '\n') {
+            pos++;
+        }
+        bounds[i] = pos;
+    }
+    return bounds;
+}
+
+// Like splitAtNewlines, but boundaries fall at the start of a blank line so that no blank-line-delimited record
+// straddles two chunks.
+inline std::vector<size_t> splitAtBlankLines(std::string_view text, size_t chunkCount) {
+    std::vector<size_t> bounds(chunkCount + 1);
+    bounds[chunkCount] = text.size();
+    for (size_t i = 1; i < chunkCount; i++) {
+        size_t pos = std::max(text.size() * i / chunkCount, bounds[i - 1]);
+        while (pos < text.size()) {
+            pos = text.find('\n', pos);
+            if (pos == text.npos) {
+                pos = text.size();
+                break;
+            }
+            pos++;
+            if (pos < text.size() && (text[pos] == '\n' || (text[pos] == '\r' && pos + 1 < text.size() && text[pos + 1] == '\n'))) {
+                break;
+            }
+        }
+        bounds[i] = pos;
+    }
+    return bounds;
+}
+
+// Memory-maps the file at path and splits it with split (splitAtNewlines or splitAtBlankLines) into one chunk per
+// hardware thread, keeping at least 4 KiB per chunk. process(chunk, text) runs on every chunk concurrently, where
+// text is the whole file, and the per-chunk results are combined with Result::Merge.
+template <typename Result, typename Process>
+Result processChunks(const char* path, std::vector<size_t> (*split)(std::string_view, size_t), Process&& process) {
+    MappedFile file{ path };
+    auto text = file.text();
+    size_t chunkCount = std::clamp<size_t>(text.size() / 4096, 1, hardwareThreads());
+    auto bounds = split(text, chunkCount);
+    std::vector<Result> results(chunkCount);
+    runTasks(chunkCount, [&](size_t chunk) {
+        results[chunk] = process(text.substr(bounds[chunk], bounds[chunk + 1] - bounds[chunk]), text);
+    });
+
+    Result total;
+    for (auto& result : results) {
+        total.Merge(result);
+    }
+    return total;
+}
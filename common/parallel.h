@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Number of threads to split work across: AOC_THREADS if it is set to a positive number, otherwise the number of
+// hardware threads
+inline size_t hardwareThreads() {
+    static const size_t threads = [] {
+        size_t fromEnvironment = 0;
+#if defined(_WIN32)
+        char* value = nullptr;
+        size_t length = 0;
+        if (_dupenv_s(&value, &length, "AOC_THREADS") == 0 && value != nullptr) {
+            fromEnvironment = std::strtoull(value, nullptr, 10);
+            std::free(value);
+        }
+#else
+        if (const char* value = std::getenv("AOC_THREADS")) {
+            fromEnvironment = std::strtoull(value, nullptr, 10);
+        }
+#endif
+        return (fromEnvironment > 0) ? fromEnvironment : std::max<size_t>(1, std::thread::hardware_concurrency());
+    }();
+    return threads;
+}
+
+// Calls func(index) for every index in [0, taskCount), each on its own thread, and waits for all of them.
+// The calling thread runs task 0.
+template <typename Func>
+void runTasks(size_t taskCount, Func&& func) {
+    std::vector<std::thread> threads;
+    threads.reserve(taskCount);
+    for (size_t index = 1; index < taskCount; index++) {
+        threads.emplace_back([&func, index] { func(index); });
+    }
+    if (taskCount > 0) {
+        func(size_t{ 0 });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Splits [0, count) into one contiguous range per hardware thread (fewer if count is small) and calls
+// func(chunkIndex, begin, end) for each range concurrently. Returns the number of chunks used.
+template <typename Func>
+size_t parallelForRanges(size_t count, Func&& func) {
+    size_t chunkCount = std::clamp<size_t>(count, 1, hardwareThreads());
+    runTasks(chunkCount, [&](size_t chunk) {
+        func(chunk, count * chunk / chunkCount, count * (chunk + 1) / chunkCount);
+    });
+    return chunkCount;
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Declarative validation for records made of "key:value" fields.
+//
+// A schema is a text file with one field per line (blank lines and lines starting with '#' are ignored):
+//   <name> <required|optional> <rule> [arguments...]
+// Rules:
+//   any                                      no constraint
+//   range <min> <max> [<digits>]             decimal integer in [min, max], optionally with exactly <digits> digits
+//   units <unit> <min> <max> [<unit> ...]    decimal integer without leading zeros followed by one of the units,
+//                                            within that unit's range
+//   hexcolor                                 '#' followed by 6 lowercase hex digits
+//   enum <value> [<value> ...]               one of the listed values
+//   digits <count>                           exactly <count> decimal digits
+
+struct FieldRule {
+    enum class Kind { Any, Range, Units, HexColor, Enum, Digits };
+
+    struct UnitRange {
+        std::string unit;
+        int64_t min, max;
+    };
+
+    Kind kind = Kind::Any;
+    int64_t min = 0;
+    int64_t max = 0;
+    size_t digits = 0;
+    std::vector<UnitRange> units;
+    std::vector<std::string> values;
+
+    bool Check(std::string_view value) const {
+        switch (kind) {
+        case Kind::Any: return true;
+        case Kind::Range: {
+            if (digits != 0 && value.size() != digits) return false;
+            auto number = parseNumber(value);
+            return number && *number >= min && *number <= max;
+        }
+        case Kind::Units:
+            for (auto& range : units) {
+                if (value.size() <= range.unit.size() || !value.ends_with(range.unit)) continue;
+                auto digitsPart = value.substr(0, value.size() - range.unit.size());
+                if (digitsPart.size() > 1 && digitsPart[0] == '0') return false;
+                auto number = parseNumber(digitsPart);
+                return number && *number >= range.min && *number <= range.max;
+            }
+            return false;
+        case Kind::HexColor:
+            return value.size() == 7 && value[0] == '#' && std::all_of(value.begin() + 1, value.end(), [](char ch) {
+                return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f');
+            });
+        case Kind::Enum:
+            return std::find(values.begin(), values.end(), value) != values.end();
+        case Kind::Digits:
+            return value.size() == digits && parseNumber(value).has_value();
+        }
+        return false;
+    }
+
+    static std::optional<int64_t> parseNumber(std::string_view value) {
+        if (value.empty() || value.size() > 18) return std::nullopt;
+        int64_t number = 0;
+        for (char ch : value) {
+            if (ch < '0' || ch > '9') return std::nullopt;
+            number = number * 10 + (ch - '0');
+        }
+        return number;
+    }
+};
+
+struct SchemaField {
+    std::string name;
+    bool required;
+    FieldRule rule;
+};
+
+// A record's field values, indexed like the schema's fields; present has one bit per field found in the record
+struct SchemaRecord {
+    std::vector<std::string_view> values;
+    uint64_t present = 0;
+};
+
+struct ValidationStats {
+    size_t records = 0;
+    size_t valid = 0;
+    // Per schema field: records rejected because the field was missing or because its rule failed.
+    // Validation stops at the first failure, so each rejected record is counted exactly once.
+    std::vector<size_t> missing;
+    std::vector<size_t> invalid;
+};
+
+struct RecordSchema {
+    static constexpr size_t kMaxFields = 64;
+
+    std::vector<SchemaField> fields;
+    std::map<std::string, size_t, std::less<>> fieldIndices;
+    uint64_t requiredMask = 0;
+
+    // Parses a schema, returning std::nullopt and a description of the problem in error if it is malformed
+    static std::optional<RecordSchema> Parse(std::istream& is, std::string& error) {
+        RecordSchema schema;
+        std::string line;
+        size_t lineNumber = 0;
+        while (std::getline(is, line)) {
+            lineNumber++;
+            std::istringstream ss{ line };
+            SchemaField field;
+            std::string requirement;
+            std::string kind;
+            if (!(ss >> field.name) || field.name[0] == '#') continue;
+
+            auto fail = [&](const std::string& message) {
+                error = "line " + std::to_string(lineNumber) + ": " + message;
+                return std::nullopt;
+            };
+            if (!(ss >> requirement >> kind)) return fail("expected <name> <required|optional> <rule>");
+            if (requirement != "required" && requirement != "optional") return fail("unknown requirement " + requirement);
+            if (schema.fieldIndices.contains(field.name)) return fail("duplicate field " + field.name);
+            if (schema.fields.size() == kMaxFields) return fail("too many fields");
+            field.required = (requirement == "required");
+
+            auto& rule = field.rule;
+            if (kind == "any") {
+                rule.kind = FieldRule::Kind::Any;
+            }
+            else if (kind == "range") {
+                rule.kind = FieldRule::Kind::Range;
+                if (!(ss >> rule.min >> rule.max)) return fail("range needs <min> <max>");
+                ss >> rule.digits;
+            }
+            else if (kind == "units") {
+                rule.kind = FieldRule::Kind::Units;
+                FieldRule::UnitRange range;
+                while (ss >> range.unit >> range.min >> range.max) {
+                    rule.units.push_back(range);
+                }
+                if (rule.units.empty()) return fail("units needs at least one <unit> <min> <max>");
+            }
+            else if (kind == "hexcolor") {
+                rule.kind = FieldRule::Kind::HexColor;
+            }
+            else if (kind == "enum") {
+                rule.kind = FieldRule::Kind::Enum;
+                std::string value;
+                while (ss >> value) {
+                    rule.values.push_back(value);
+                }
+                if (rule.values.empty()) return fail("enum needs at least one value");
+            }
+            else if (kind == "digits") {
+                rule.kind = FieldRule::Kind::Digits;
+                if (!(ss >> rule.digits) || rule.digits == 0) return fail("digits needs a positive <count>");
+            }
+            else {
+                return fail("unknown rule " + kind);
+            }
+
+            if (field.required) {
+                schema.requiredMask |= uint64_t{ 1 } << schema.fields.size();
+            }
+            schema.fieldIndices.emplace(field.name, schema.fields.size());
+            schema.fields.push_back(std::move(field));
+        }
+        return schema;
+    }
+
+    // Adds a "key:value" field to the record; keys not in the schema are ignored
+    void SetField(SchemaRecord& record, std::string_view key, std::string_view value) const {
+        auto it = fieldIndices.find(key);
+        if (it == fieldIndices.end()) return;
+        record.values.resize(fields.size());
+        record.values[it->second] = value;
+        record.present |= uint64_t{ 1 } << it->second;
+    }
+
+    // Validates a batch of records, stopping at the first failing field of each record and counting the failure
+    void Validate(std::span<const SchemaRecord> records, ValidationStats& stats) const {
+        stats.missing.resize(fields.size());
+        stats.invalid.resize(fields.size());
+        for (auto& record : records) {
+            stats.records++;
+            if ((record.present & requiredMask) != requiredMask) {
+                auto missingBits = requiredMask & ~record.present;
+                stats.missing[std::countr_zero(missingBits)]++;
+                continue;
+            }
+            bool valid = true;
+            for (size_t i = 0; i < fields.size(); i++) {
+                if (!(record.present & (uint64_t{ 1 } << i))) continue;
+                if (!fields[i].rule.Check(record.values[i])) {
+                    stats.invalid[i]++;
+                    valid = false;
+                    break;
+                }
+            }
+            if (valid) stats.valid++;
+        }
+    }
+};
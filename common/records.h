@@ -0,0 +1,123 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// An input file held in memory, split into lines and blank-line-delimited records in a single pass.
+// Lines are views into the buffer, so loaders can parse them without copying. Blank lines are not stored;
+// they only mark record boundaries. The buffer is a vector so moving a RecordFile never invalidates the views.
+struct RecordFile {
+    RecordFile() = default;
+    RecordFile(RecordFile&&) = default;
+    RecordFile(const RecordFile&) = delete;
+
+    std::vector<char> buffer;
+    std::vector<std::string_view> lines;
+
+    // Index into lines of the first line of each record, followed by a sentinel equal to lines.size()
+    std::vector<size_t> recordStarts{ 0 };
+
+    size_t recordCount() const {
+        return recordStarts.size() - 1;
+    }
+
+    std::span<const std::string_view> record(size_t index) const {
+        return { lines.data() + recordStarts[index], lines.data() + recordStarts[index + 1] };
+    }
+};
+
+// Invokes func with the position of every '\n' in text, in order.
+// Uses 32-byte compare + movemask scans when AVX2 is available, falling back to memchr otherwise.
+template <typename Func>
+void forEachNewline(std::string_view text, Func&& func) {
+    size_t pos = 0;
+#if defined(__AVX2__)
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (; pos + 32 <= text.size(); pos += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + pos));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+        while (mask != 0) {
+            func(pos + std::countr_zero(mask));
+            mask &= mask - 1;
+        }
+    }
+#endif
+    while (pos < text.size()) {
+        auto* found = static_cast<const char*>(std::memchr(text.data() + pos, '\n', text.size() - pos));
+        if (found == nullptr) break;
+        size_t newlinePos = found - text.data();
+        func(newlinePos);
+        pos = newlinePos + 1;
+    }
+}
+
+// Invokes func with every line of text, without its "\n" or "\r\n" ending. Blank lines are passed as empty views so
+// callers can treat them as record separators.
+template <typename Func>
+void forEachLine(std::string_view text, Func&& func) {
+    size_t lineStart = 0;
+    auto emitLine = [&](size_t lineEnd) {
+        auto line = text.substr(lineStart, lineEnd - lineStart);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        func(line);
+        lineStart = lineEnd + 1;
+    };
+    forEachNewline(text, emitLine);
+    if (lineStart < text.size()) {
+        emitLine(text.size());
+    }
+}
+
+inline RecordFile splitRecords(std::vector<char> buffer) {
+    RecordFile file;
+    file.buffer = std::move(buffer);
+    forEachLine({ file.buffer.data(), file.buffer.size() }, [&](std::string_view line) {
+        if (line.empty()) {
+            // Blank line closes the current record, unless it's empty
+            if (file.recordStarts.back() != file.lines.size()) {
+                file.recordStarts.push_back(file.lines.size());
+            }
+        }
+        else {
+            file.lines.push_back(line);
+        }
+    });
+    if (file.recordStarts.back() != file.lines.size()) {
+        file.recordStarts.push_back(file.lines.size());
+    }
+    return file;
+}
+
+// Reads the whole file with one sized read, then splits it
+inline RecordFile loadRecords(const char* path) {
+    std::ifstream f{ path, std::ios::binary | std::ios::ate };
+    std::vector<char> buffer(f ? static_cast<size_t>(f.tellg()) : 0);
+    f.seekg(0);
+    f.read(buffer.data(), buffer.size());
+    return splitRecords(std::move(buffer));
+}
+
+// Invokes func with each non-empty field in line separated by sep.
+template <typename Func>
+void forEachField(std::string_view line, char sep, Func&& func) {
+    while (!line.empty()) {
+        auto sepPos = line.find(sep);
+        auto field = line.substr(0, sepPos);
+        if (!field.empty()) {
+            func(field);
+        }
+        if (sepPos == line.npos) break;
+        line.remove_prefix(sepPos + 1);
+    }
+}
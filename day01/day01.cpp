@@ -1,41 +1,399 @@
-#include <unordered_set>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
 #include <iostream>
 #include <fstream>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
-// Part 1 - Two sum
-void part1(const std::vector<int>& nums) {
-    std::unordered_set<int> complements;
-    for (int num : nums) {
-        int complement = 2020 - num;
-        if (complements.contains(num)) {
-            int result = num * complement;
-            std::cout << "part 1: " << result << " (" << num << ", " << complement << ")\n";
-            break;
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "../common/parallel.h"
+
+using u32 = uint32_t;
+using s64 = int64_t;
+
+// LSD radix sort on 8-bit digits. The sign bit is flipped so negative numbers sort before positive ones.
+std::vector<int> radixSort(const std::vector<int>& nums) {
+    std::vector<int> sorted{ nums };
+    std::vector<int> scratch(nums.size());
+    for (u32 shift = 0; shift < 32; shift += 8) {
+        size_t offsets[257] = {};
+        auto digit = [&](int num) { return ((static_cast<u32>(num) ^ 0x8000'0000u) >> shift) & 0xFF; };
+        for (int num : sorted) {
+            offsets[digit(num) + 1]++;
+        }
+        for (size_t i = 1; i < 257; i++) {
+            offsets[i] += offsets[i - 1];
+        }
+        for (int num : sorted) {
+            scratch[offsets[digit(num)]++] = num;
         }
-        complements.insert(complement);
+        sorted.swap(scratch);
     }
+    return sorted;
 }
 
-// Part 2 - Three sum
-void part2(const std::vector<int>& nums) {
-    for (size_t i = 0; i < nums.size(); i++) {
-        int num1 = nums[i];
+// Finds k entries of sorted[start..] (distinct positions) that add up to target, appending them to result in
+// ascending order. Returns false and leaves result untouched if there is no solution.
+//  - k == 1 is a binary search
+//  - k == 2 is a two-pointer sweep
+//  - k == 3 fixes the smallest entry and sweeps the remaining pair
+//  - k == 4 is a meet-in-the-middle over pair sums
+//  - k >= 5 fixes the smallest entry and recurses
+bool kSumSorted(std::span<const int> sorted, size_t start, size_t k, s64 target, std::vector<int>& result) {
+    const size_t n = sorted.size();
+    if (k == 0 || n - start < k) {
+        return false;
+    }
+
+    if (k == 1) {
+        if (std::binary_search(sorted.begin() + start, sorted.end(), target)) {
+            result.push_back(static_cast<int>(target));
+            return true;
+        }
+        return false;
+    }
+
+    if (k == 2) {
+        size_t lo = start;
+        size_t hi = n - 1;
+        while (lo < hi) {
+            s64 sum = (s64)sorted[lo] + sorted[hi];
+            if (sum == target) {
+                result.push_back(sorted[lo]);
+                result.push_back(sorted[hi]);
+                return true;
+            }
+            if (sum < target) lo++;
+            else hi--;
+        }
+        return false;
+    }
+
+    if (k == 4) {
+        // Walk the third entry c forward; before checking the pairs (c, d) for d > c, every pair (a, b) with
+        // b < c is already in the table, so the four positions are always distinct.
+        std::unordered_map<s64, std::pair<size_t, size_t>> pairSums;
+        pairSums.reserve(std::min<size_t>((n - start) * (n - start) / 2, size_t{ 1 } << 22));
+        for (size_t c = start + 2; c + 1 < n; c++) {
+            size_t b = c - 1;
+            for (size_t a = start; a < b; a++) {
+                pairSums.try_emplace((s64)sorted[a] + sorted[b], a, b);
+            }
+            for (size_t d = c + 1; d < n; d++) {
+                auto it = pairSums.find(target - sorted[c] - sorted[d]);
+                if (it != pairSums.end()) {
+                    auto [a, b] = it->second;
+                    result.insert(result.end(), { sorted[a], sorted[b], sorted[c], sorted[d] });
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    for (size_t i = start; i + k <= n; i++) {
+        // Equal values give the same subproblem with fewer candidates
+        if (i > start && sorted[i] == sorted[i - 1]) continue;
+        // Every remaining sum is at least k * sorted[i] and at most sorted[i] + (k - 1) * max
+        if ((s64)sorted[i] * (s64)k > target) break;
+        if ((s64)sorted[i] + (s64)sorted[n - 1] * (s64)(k - 1) < target) continue;
+        result.push_back(sorted[i]);
+        if (kSumSorted(sorted, i + 1, k - 1, target - sorted[i], result)) {
+            return true;
+        }
+        result.pop_back();
+    }
+    return false;
+}
+
+// Finds k entries of nums that add up to target, returned in ascending order, or an empty vector if there is no
+// solution. k < 3 and k == 4 run directly (k == 4 is the O(n^2) meet-in-the-middle; fixing its first entry would
+// leave an O(n^2) three sum per entry). For k == 3 and k >= 5 the choice of the smallest entry is spread across
+// hardwareThreads(); the solution with the smallest leading entry is reported so the result doesn't depend on
+// scheduling.
+std::vector<int> kSum(const std::vector<int>& nums, size_t k, s64 target) {
+    auto sorted = radixSort(nums);
+    std::vector<int> result;
+    if (k < 3 || k == 4) {
+        kSumSorted(sorted, 0, k, target, result);
+        return result;
+    }
+
+    const size_t n = sorted.size();
+    std::atomic<size_t> nextIndex{ 0 };
+    std::atomic<size_t> bestIndex{ n };
+    std::mutex resultMutex;
+
+    auto worker = [&] {
+        std::vector<int> local;
+        for (size_t i = nextIndex++; i + k <= n && i < bestIndex.load(std::memory_order_relaxed); i = nextIndex++) {
+            if (i > 0 && sorted[i] == sorted[i - 1]) continue;
+            if ((s64)sorted[i] * (s64)k > target) break;
+            if ((s64)sorted[i] + (s64)sorted[n - 1] * (s64)(k - 1) < target) continue;
+            local.clear();
+            local.push_back(sorted[i]);
+            if (!kSumSorted(sorted, i + 1, k - 1, target - sorted[i], local)) continue;
+
+            std::lock_guard lock{ resultMutex };
+            if (i < bestIndex) {
+                bestIndex = i;
+                result = local;
+            }
+            break;
+        }
+    };
+
+    runTasks(hardwareThreads(), [&](size_t) { worker(); });
+    return result;
+}
+
+// Index over an expense list for answering many pair/triple sum queries against the same entries.
+// Sums are reported as combinations of values (not positions), each in ascending order, using an entry value
+// at most as many times as it appears in the list.
+struct ExpenseIndex {
+    using Pair = std::array<int, 2>;
+    using Triple = std::array<int, 3>;
+
+    // Value ranges up to this size get a dense presence bitmap; wider ones use the sorted values only
+    static constexpr s64 kMaxBitmapRange = s64{ 1 } << 24;
+    // Keeps target - value within 32 bits in the vectorized probes
+    static constexpr s64 kMaxBitmapMagnitude = s64{ 1 } << 29;
+
+    ExpenseIndex(const std::vector<int>& nums) {
+        auto sorted = radixSort(nums);
+        for (int num : sorted) {
+            if (values.empty() || values.back() != num) {
+                values.push_back(num);
+                counts.push_back(0);
+            }
+            counts.back()++;
+        }
+        if (values.empty()) {
+            return;
+        }
+
+        s64 minValue = values.front();
+        s64 maxValue = values.back();
+        if (maxValue - minValue < kMaxBitmapRange && -minValue <= kMaxBitmapMagnitude && maxValue <= kMaxBitmapMagnitude) {
+            bitmapBase = static_cast<int>(minValue);
+            bitmapSize = static_cast<u32>(maxValue - minValue + 1);
+            bitmap.resize((bitmapSize + 31) / 32);
+            for (int value : values) {
+                u32 index = static_cast<u32>(value - bitmapBase);
+                bitmap[index / 32] |= 1u << (index % 32);
+            }
+        }
+    }
+
+    // Distinct values in ascending order and the number of times each appears
+    std::vector<int> values;
+    std::vector<u32> counts;
+
+    // Presence bitmap over [bitmapBase, bitmapBase + bitmapSize); empty if the values are too spread out
+    int bitmapBase = 0;
+    u32 bitmapSize = 0;
+    std::vector<u32> bitmap;
+
+    u32 Count(s64 value) const {
+        auto it = std::lower_bound(values.begin(), values.end(), value);
+        return (it != values.end() && *it == value) ? counts[it - values.begin()] : 0;
+    }
+
+    // Pairs a <= b with a + b == target
+    std::vector<Pair> FindPairs(s64 target, bool firstOnly) const {
+        std::vector<Pair> pairs;
+        size_t end = std::upper_bound(values.begin(), values.end(), target / 2) - values.begin();
+        ProbeComplements(0, end, target, [&](size_t i) {
+            s64 complement = target - values[i];
+            if (complement < values[i]) return true;
+            if (complement == values[i] && counts[i] < 2) return true;
+            pairs.push_back({ values[i], static_cast<int>(complement) });
+            return !firstOnly;
+        });
+        return pairs;
+    }
 
-        int remainingSum = 2020 - num1;
+    // Triples a <= b <= c with a + b + c == target
+    std::vector<Triple> FindTriples(s64 target, bool firstOnly) const {
+        std::vector<Triple> triples;
+        for (size_t i = 0; i < values.size(); i++) {
+            s64 a = values[i];
+            if (a * 3 > target) break;
+            s64 remaining = target - a;
+            size_t end = std::upper_bound(values.begin() + i, values.end(), remaining / 2) - values.begin();
+            bool keepGoing = true;
+            ProbeComplements(i, end, remaining, [&](size_t j) {
+                s64 b = values[j];
+                s64 c = remaining - b;
+                if (c < b) return true;
+                u32 needA = 1 + (b == a) + (c == a);
+                u32 needB = (b == c) ? 2 : 1;
+                if (counts[i] < needA || (b != a && counts[j] < needB)) return true;
+                triples.push_back({ static_cast<int>(a), static_cast<int>(b), static_cast<int>(c) });
+                keepGoing = !firstOnly;
+                return keepGoing;
+            });
+            if (!keepGoing) break;
+        }
+        return triples;
+    }
 
-        std::unordered_set<int> complements;
-        for (size_t j = i + 1; j < nums.size(); j++) {
-            int num2 = nums[j];
-            int complement = remainingSum - num2;
-            if (complements.contains(num2)) {
-                int result = num1 * num2 * complement;
-                std::cout << "part 2: " << result << " (" << num1 << ", " << num2 << ", " << complement << ")\n";
-                break;
+    // Batched queries: one result list per target
+    std::vector<std::vector<Pair>> FindPairs(std::span<const s64> targets, bool firstOnly) const {
+        std::vector<std::vector<Pair>> results;
+        results.reserve(targets.size());
+        for (s64 target : targets) {
+            results.push_back(FindPairs(target, firstOnly));
+        }
+        return results;
+    }
+
+    std::vector<std::vector<Triple>> FindTriples(std::span<const s64> targets, bool firstOnly) const {
+        std::vector<std::vector<Triple>> results;
+        results.reserve(targets.size());
+        for (s64 target : targets) {
+            results.push_back(FindTriples(target, firstOnly));
+        }
+        return results;
+    }
+
+private:
+    bool BitmapContains(s64 value) const {
+        s64 index = value - bitmapBase;
+        if (index < 0 || index >= bitmapSize) return false;
+        return (bitmap[index / 32] >> (index % 32)) & 1;
+    }
+
+    // Calls func(i) in ascending order for every i in [begin, end) where target - values[i] is in the index,
+    // stopping early if func returns false.
+    // With a bitmap, complements are probed 8 at a time using AVX2 gathers when available; otherwise a pointer
+    // walks down the sorted values as the complements decrease.
+    template <typename Func>
+    void ProbeComplements(size_t begin, size_t end, s64 target, Func&& func) const {
+        if (bitmap.empty()) {
+            size_t hi = values.size();
+            for (size_t i = begin; i < end; i++) {
+                s64 complement = target - values[i];
+                while (hi > 0 && values[hi - 1] > complement) hi--;
+                if (hi > 0 && values[hi - 1] == complement) {
+                    if (!func(i)) return;
+                }
             }
-            complements.insert(complement);
+            return;
+        }
+
+        size_t i = begin;
+#if defined(__AVX2__)
+        if (target >= -kMaxBitmapMagnitude && target <= kMaxBitmapMagnitude) {
+            const __m256i targetVec = _mm256_set1_epi32(static_cast<int>(target - bitmapBase));
+            const __m256i limitVec = _mm256_set1_epi32(static_cast<int>(bitmapSize));
+            const __m256i one = _mm256_set1_epi32(1);
+            for (; i + 8 <= end; i += 8) {
+                __m256i valueVec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values.data() + i));
+                __m256i index = _mm256_sub_epi32(targetVec, valueVec);
+                __m256i inRange = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), index),
+                    _mm256_cmpgt_epi32(limitVec, index));
+                __m256i words = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), reinterpret_cast<const int*>(bitmap.data()),
+                    _mm256_srli_epi32(index, 5), inRange, 4);
+                __m256i bits = _mm256_and_si256(_mm256_srlv_epi32(words, _mm256_and_si256(index, _mm256_set1_epi32(31))), one);
+                u32 hits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(bits, inRange), one)));
+                while (hits != 0) {
+                    if (!func(i + std::countr_zero(hits))) return;
+                    hits &= hits - 1;
+                }
+            }
+        }
+#endif
+        for (; i < end; i++) {
+            if (BitmapContains(target - values[i])) {
+                if (!func(i)) return;
+            }
+        }
+    }
+};
+
+// Two sum over a stream of entries, restricted to pairs within the last `window` entries.
+// The window is a ring buffer and an entry count per value; pair counts are updated as entries arrive and expire,
+// so each Push is O(1) amortized and memory is bounded by the window size.
+struct StreamingTwoSum {
+    StreamingTwoSum(size_t window, s64 target)
+        : ring(window)
+        , target(target) {
+        counts.reserve(window);
+    }
+
+    std::vector<int> ring;
+    size_t head = 0;
+    size_t size = 0;
+    std::unordered_map<s64, u32> counts;
+    s64 target;
+    size_t pairCount = 0;
+
+    void Push(int num) {
+        if (ring.empty()) return;
+        if (size == ring.size()) {
+            Expire(ring[head]);
+        }
+        else {
+            size++;
+        }
+        auto it = counts.find(target - num);
+        if (it != counts.end()) {
+            pairCount += it->second;
+        }
+        counts[num]++;
+        ring[head] = num;
+        head = (head + 1) % ring.size();
+    }
+
+    // Whether any two entries in the current window add up to the target
+    bool HasPair() const {
+        return pairCount > 0;
+    }
+
+    // Number of pairs of entries (by position) in the current window that add up to the target
+    size_t PairCount() const {
+        return pairCount;
+    }
+
+private:
+    void Expire(int num) {
+        auto it = counts.find(num);
+        if (--it->second == 0) {
+            counts.erase(it);
+        }
+        auto complement = counts.find(target - num);
+        if (complement != counts.end()) {
+            pairCount -= complement->second;
         }
     }
+};
+
+// Part 1 - Two sum
+void part1(const ExpenseIndex& index) {
+    auto pairs = index.FindPairs(2020, true);
+    if (pairs.empty()) return;
+    auto [num1, num2] = pairs[0];
+    std::cout << "part 1: " << (num1 * num2) << " (" << num1 << ", " << num2 << ")\n";
+}
+
+// Part 2 - Three sum
+void part2(const ExpenseIndex& index) {
+    auto triples = index.FindTriples(2020, true);
+    if (triples.empty()) return;
+    auto [num1, num2, num3] = triples[0];
+    std::cout << "part 2: " << (num1 * num2 * num3) << " (" << num1 << ", " << num2 << ", " << num3 << ")\n";
 }
 
 std::vector<int> loadInput() {
@@ -48,9 +406,50 @@ std::vector<int> loadInput() {
     return nums;
 }
 
-int main() {
+// Streaming mode: reads entries from stdin and prints the number of pairs in the window after each one
+void stream(size_t window, s64 target) {
+    StreamingTwoSum twoSum{ window, target };
+    int num;
+    while (std::cin >> num) {
+        twoSum.Push(num);
+        std::cout << num << ": " << twoSum.PairCount() << "\n";
+    }
+}
+
+// Prints k entries of the input that add up to target, and their product
+void printKSum(const std::vector<int>& nums, size_t k, s64 target) {
+    auto entries = kSum(nums, k, target);
+    if (entries.empty()) {
+        std::cout << "no " << k << " entries add up to " << target << "\n";
+        return;
+    }
+    s64 product = 1;
+    for (int entry : entries) {
+        product *= entry;
+    }
+    std::cout << product << " (";
+    for (size_t i = 0; i < entries.size(); i++) {
+        std::cout << (i > 0 ? ", " : "") << entries[i];
+    }
+    std::cout << ")\n";
+}
+
+int main(int argc, char* argv[]) {
+    // day01 --ksum <k> [target]
+    if (argc >= 3 && std::string_view{ argv[1] } == "--ksum") {
+        printKSum(loadInput(), std::stoull(argv[2]), (argc >= 4) ? std::stoll(argv[3]) : 2020);
+        return 0;
+    }
+
+    // day01 --stream <window> [target]
+    if (argc >= 3 && std::string_view{ argv[1] } == "--stream") {
+        stream(std::stoull(argv[2]), (argc >= 4) ? std::stoll(argv[3]) : 2020);
+        return 0;
+    }
+
     auto nums = loadInput();
-    part1(nums);
-    part2(nums);
+    ExpenseIndex index{ nums };
+    part1(index);
+    part2(index);
     return 0;
 }
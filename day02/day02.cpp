@@ -1,67 +1,235 @@
 #include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
 #include <fstream>
+#include <string>
+#include <string_view>
 #include <vector>
-#include <ranges>
 
-struct Password {
-    size_t num1;
-    size_t num2;
-    char ch;
-    std::string password;
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "../common/mapped_file.h"
+
+using u32 = uint32_t;
 
+// Password database stored as columns. Passwords are packed back to back in a single byte arena, addressed by
+// offset and length, so batch kernels can sweep the columns without chasing per-record allocations.
+struct PasswordDatabase {
+    // Bytes of slack after the last password so vector loads and gathers never read past the arena
+    static constexpr size_t kArenaPadding = 32;
 
-    bool valid1() const {
-        size_t count = std::ranges::count(password, ch);
-        return (count >= num1) && (count <= num2);
+    std::vector<char> arena = std::vector<char>(kArenaPadding);
+    std::vector<u32> offsets;
+    std::vector<u32> lengths;
+    std::vector<u32> num1;
+    std::vector<u32> num2;
+    std::vector<char> ch;
+
+    size_t size() const {
+        return offsets.size();
     }
 
-    bool valid2() const {
-        bool pos1 = (password[num1 - 1] == ch);
-        bool pos2 = (password[num2 - 1] == ch);
-        return pos1 != pos2;
+    void Add(u32 min, u32 max, char c, std::string_view password) {
+        size_t offset = arena.size() - kArenaPadding;
+        if (offset + password.size() > std::numeric_limits<u32>::max()) {
+            // Offsets are 32-bit; the arena can't grow past 4 GiB
+            std::abort();
+        }
+        arena.insert(arena.end() - kArenaPadding, password.begin(), password.end());
+        offsets.push_back(static_cast<u32>(offset));
+        lengths.push_back(static_cast<u32>(password.size()));
+        num1.push_back(min);
+        num2.push_back(max);
+        ch.push_back(c);
+    }
+
+    std::string_view Password(size_t index) const {
+        return { arena.data() + offsets[index], lengths[index] };
+    }
+
+    // num1 and num2 specify the minimum and maximum number of times (respectively) ch must appear in the password
+    bool Valid1(size_t index) const {
+        size_t count = std::ranges::count(Password(index), ch[index]);
+        return (count >= num1[index]) && (count <= num2[index]);
     }
 
-    friend std::istream& operator>>(std::istream& is, Password& password) {
-        // line format:
-        // <num1>-<num2> <ch>: <password>
-        char discard;
-        return is >> password.num1 >> discard >> password.num2 >> password.ch >> discard >> password.password;
+    // ch must appear exactly once in positions num1 and num2 (1-based)
+    bool Valid2(size_t index) const {
+        auto password = Password(index);
+        bool pos1 = (num1[index] - 1 < password.size()) && (password[num1[index] - 1] == ch[index]);
+        bool pos2 = (num2[index] - 1 < password.size()) && (password[num2[index] - 1] == ch[index]);
+        return pos1 != pos2;
     }
 };
 
-// Part 1 - Count valid passwords where num1 and num2 specify the minimum and maximum number of times (respectively)
-// ch must appear in the password
-void part1(const std::vector<Password>& passwords) {
+// Counts records that satisfy Valid1. With AVX2, each password is compared 32 bytes at a time against the
+// broadcast policy character and matches are counted with popcount on the compare mask.
+size_t countValid1(const PasswordDatabase& db) {
     size_t validCount = 0;
-    for (auto& password : passwords) {
-        if (password.valid1()) validCount++;
+    for (size_t i = 0; i < db.size(); i++) {
+#if defined(__AVX2__)
+        const char* password = db.arena.data() + db.offsets[i];
+        const u32 length = db.lengths[i];
+        const __m256i chVec = _mm256_set1_epi8(db.ch[i]);
+        u32 count = 0;
+        for (u32 pos = 0; pos < length; pos += 32) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(password + pos));
+            u32 mask = static_cast<u32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, chVec)));
+            u32 remaining = length - pos;
+            if (remaining < 32) {
+                mask &= (1u << remaining) - 1;
+            }
+            count += std::popcount(mask);
+        }
+        if (count >= db.num1[i] && count <= db.num2[i]) validCount++;
+#else
+        if (db.Valid1(i)) validCount++;
+#endif
     }
-    std::cout << "part 1: " << validCount << "\n";
+    return validCount;
 }
 
-// Part 2 - Count valid passwords where ch must appear exactly once in positions num1 and num2 (1-based)
-void part2(const std::vector<Password>& passwords) {
+// Counts records that satisfy Valid2. With AVX2, 8 records are checked at once by gathering the bytes at both
+// positions straight from the arena and comparing them against the policy characters.
+// Gather indices are signed 32-bit, so each batch gathers relative to its first password; records are stored in
+// order, so the batch's offsets only span its own 8 passwords.
+size_t countValid2(const PasswordDatabase& db) {
     size_t validCount = 0;
-    for (auto& password : passwords) {
-        if (password.valid2()) validCount++;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    for (; i + 8 <= db.size(); i += 8) {
+        auto load = [&](const std::vector<u32>& column) {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column.data() + i));
+        };
+        const u32 batchOffset = db.offsets[i];
+        const int* arena = reinterpret_cast<const int*>(db.arena.data() + batchOffset);
+        __m256i offsets = _mm256_sub_epi32(load(db.offsets), _mm256_set1_epi32(static_cast<int>(batchOffset)));
+        __m256i lengths = load(db.lengths);
+        __m256i chVec = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(db.ch.data() + i)));
+
+        auto matchesAt = [&](__m256i pos) {
+            // 1-based position must fall within the password
+            __m256i index = _mm256_sub_epi32(pos, one);
+            __m256i inRange = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), index),
+                _mm256_cmpgt_epi32(lengths, index));
+            __m256i bytes = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), arena,
+                _mm256_add_epi32(offsets, index), inRange, 1);
+            return _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(bytes, byteMask), chVec), inRange);
+        };
+        __m256i valid = _mm256_xor_si256(matchesAt(load(db.num1)), matchesAt(load(db.num2)));
+        validCount += std::popcount(static_cast<u32>(_mm256_movemask_ps(_mm256_castsi256_ps(valid))));
     }
-    std::cout << "part 2: " << validCount << "\n";
+#endif
+    for (; i < db.size(); i++) {
+        if (db.Valid2(i)) validCount++;
+    }
+    return validCount;
+}
+
+// Part 1 - Count valid passwords where num1 and num2 specify the minimum and maximum number of times (respectively)
+// ch must appear in the password
+void part1(const PasswordDatabase& db) {
+    std::cout << "part 1: " << countValid1(db) << "\n";
+}
+
+// Part 2 - Count valid passwords where ch must appear exactly once in positions num1 and num2 (1-based)
+void part2(const PasswordDatabase& db) {
+    std::cout << "part 2: " << countValid2(db) << "\n";
+}
+
+struct AuditResult {
+    size_t records = 0;
+    size_t valid1 = 0;
+    size_t valid2 = 0;
+
+    void Merge(const AuditResult& result) {
+        records += result.records;
+        valid1 += result.valid1;
+        valid2 += result.valid2;
+    }
+};
+
+// Parses and validates every "<num1>-<num2> <ch>: <password>" line in text without storing any records
+AuditResult auditChunk(std::string_view text) {
+    AuditResult result;
+    const char* pos = text.data();
+    const char* end = text.data() + text.size();
+    auto parseNumber = [&]() {
+        u32 value = 0;
+        while (pos < end && *pos >= '0' && *pos <= '9') {
+            value = value * 10 + (*pos++ - '0');
+        }
+        return value;
+    };
+    while (pos < end) {
+        if (*pos == '\n' || *pos == '\r') {
+            pos++;
+            continue;
+        }
+        u32 num1 = parseNumber();
+        pos++; // '-'
+        u32 num2 = parseNumber();
+        pos++; // ' '
+        if (pos + 3 > end) break;
+        char ch = *pos;
+        pos += 3; // "<ch>: "
+        const char* password = pos;
+        while (pos < end && *pos != '\n' && *pos != '\r') {
+            pos++;
+        }
+        std::string_view pw{ password, static_cast<size_t>(pos - password) };
+
+        size_t count = std::ranges::count(pw, ch);
+        bool pos1 = (num1 - 1 < pw.size()) && (pw[num1 - 1] == ch);
+        bool pos2 = (num2 - 1 < pw.size()) && (pw[num2 - 1] == ch);
+        result.records++;
+        result.valid1 += (count >= num1) && (count <= num2);
+        result.valid2 += (pos1 != pos2);
+    }
+    return result;
+}
+
+// Audits a password dump without loading it: the file is memory-mapped, split into newline-aligned chunks
+// (one per hardware thread) that are parsed and validated in place, and the per-chunk counts are summed.
+AuditResult auditFile(const char* path) {
+    return processChunks<AuditResult>(path, splitAtNewlines, [](std::string_view chunk, std::string_view) {
+        return auditChunk(chunk);
+    });
 }
 
 auto loadInput() {
-    std::vector<Password> passwords;
+    PasswordDatabase db;
     std::ifstream f{ "input.txt" };
-    Password password;
-    while (f >> password) {
-        passwords.push_back(password);
+    // line format:
+    // <num1>-<num2> <ch>: <password>
+    u32 num1, num2;
+    char ch, discard;
+    std::string password;
+    while (f >> num1 >> discard >> num2 >> ch >> discard >> password) {
+        db.Add(num1, num2, ch, password);
     }
-    return passwords;
+    return db;
 }
 
-int main() {
-    auto passwords = loadInput();
-    part1(passwords);
-    part2(passwords);
+int main(int argc, char* argv[]) {
+    // day02 --audit <file>
+    if (argc >= 3 && std::string_view{ argv[1] } == "--audit") {
+        auto result = auditFile(argv[2]);
+        std::cout << "records: " << result.records << "\n";
+        std::cout << "part 1: " << result.valid1 << "\n";
+        std::cout << "part 2: " << result.valid2 << "\n";
+        return 0;
+    }
+
+    auto db = loadInput();
+    part1(db);
+    part2(db);
     return 0;
 }
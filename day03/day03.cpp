@@ -1,22 +1,133 @@
+#include <cstdint>
 #include <iostream>
 #include <fstream>
+#include <span>
 #include <string>
+#include <utility>
 #include <vector>
-#include <limits>
 
-void part1(const std::vector<std::string>& map) {
-    size_t x = 0;
-    size_t treeCount = 0;
-    for (size_t y = 0; y < map.size(); y++) {
-        auto& row = map[y];
-        if (row[x] == '#') treeCount++;
-        x = (x + 3) % row.size();
+#include "../common/parallel.h"
+
+using u64 = uint64_t;
+
+using Slope = std::pair<size_t, size_t>;
+
+// Map of trees packed one bit per cell, each row padded to a whole number of 64-bit words
+struct TreeMap {
+    size_t width = 0;
+    size_t height = 0;
+    size_t wordsPerRow = 0;
+    std::vector<u64> bits;
+
+    void AddRow(const std::string& row) {
+        if (height == 0) {
+            width = row.size();
+            wordsPerRow = (width + 63) / 64;
+        }
+        bits.resize(bits.size() + wordsPerRow);
+        u64* words = &bits[height * wordsPerRow];
+        for (size_t x = 0; x < width && x < row.size(); x++) {
+            if (row[x] == '#') words[x / 64] |= u64{ 1 } << (x % 64);
+        }
+        height++;
+    }
+
+    bool Tree(size_t x, size_t y) const {
+        return (bits[y * wordsPerRow + x / 64] >> (x % 64)) & 1;
     }
-    std::cout << "part 1: " << treeCount << "\n";
+};
+
+// Counts trees along every slope over rows [beginRow, endRow) in a single pass. Each slope's starting column is
+// computed in closed form from the first row it visits in the range; from there, each slope keeps its own column
+// and a countdown to its next row, so advancing needs neither division nor modulo. The map width is a template
+// parameter so that the common puzzle size gets a constant wrap-around; width == 0 uses the runtime width.
+template <size_t width>
+std::vector<size_t> countTreesInRows(const TreeMap& map, std::span<const Slope> slopes, size_t beginRow, size_t endRow) {
+    struct SlopeState {
+        size_t dx;
+        size_t dy;
+        size_t x;
+        size_t rowsUntilNext;
+        size_t treeCount = 0;
+    };
+
+    const size_t mapWidth = (width != 0) ? width : map.width;
+    std::vector<SlopeState> states;
+    states.reserve(slopes.size());
+    for (auto& [dx, dy] : slopes) {
+        // First row at or after beginRow that lies on the slope, and the column it is visited at
+        size_t step = (beginRow + dy - 1) / dy;
+        size_t firstRow = step * dy;
+        size_t x = (step % mapWidth) * (dx % mapWidth) % mapWidth;
+        states.push_back({ dx % mapWidth, dy, x, firstRow - beginRow });
+    }
+
+    for (size_t y = beginRow; y < endRow; y++) {
+        for (auto& state : states) {
+            if (state.rowsUntilNext != 0) {
+                state.rowsUntilNext--;
+                continue;
+            }
+            if constexpr (width != 0 && width <= 64) {
+                state.treeCount += (map.bits[y] >> state.x) & 1;
+            }
+            else {
+                state.treeCount += map.Tree(state.x, y);
+            }
+            state.x += state.dx;
+            if (state.x >= mapWidth) state.x -= mapWidth;
+            state.rowsUntilNext = state.dy - 1;
+        }
+    }
+
+    std::vector<size_t> treeCounts;
+    treeCounts.reserve(states.size());
+    for (auto& state : states) {
+        treeCounts.push_back(state.treeCount);
+    }
+    return treeCounts;
+}
+
+// Counts trees along every slope. Large maps are split into row ranges that are counted on separate threads and
+// summed per slope.
+template <size_t width>
+std::vector<size_t> countTrees(const TreeMap& map, std::span<const Slope> slopes) {
+    static constexpr size_t kMinRowsPerThread = 4096;
+    if (map.height < kMinRowsPerThread * 2) {
+        return countTreesInRows<width>(map, slopes, 0, map.height);
+    }
+
+    std::vector<std::vector<size_t>> chunkCounts(hardwareThreads());
+    size_t chunkCount = parallelForRanges(map.height, [&](size_t chunk, size_t beginRow, size_t endRow) {
+        chunkCounts[chunk] = countTreesInRows<width>(map, slopes, beginRow, endRow);
+    });
+
+    std::vector<size_t> treeCounts(slopes.size());
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        for (size_t i = 0; i < slopes.size(); i++) {
+            treeCounts[i] += chunkCounts[chunk][i];
+        }
+    }
+    return treeCounts;
 }
 
-void part2(const std::vector<std::string>& map) {
-    constexpr std::pair<size_t, size_t> slopes[] = {
+std::vector<size_t> countTrees(const TreeMap& map, std::span<const Slope> slopes) {
+    if (map.width == 0) {
+        return std::vector<size_t>(slopes.size());
+    }
+    if (map.width == 31) {
+        return countTrees<31>(map, slopes);
+    }
+    return countTrees<0>(map, slopes);
+}
+
+void part1(const TreeMap& map) {
+    constexpr Slope slope{ 3, 1 };
+    std::cout << "part 1: " << countTrees(map, { &slope, 1 })[0] << "\n";
+}
+
+void part2(const TreeMap& map) {
+    constexpr Slope slopes[] = {
         {1, 1},
         {3, 1},
         {5, 1},
@@ -25,27 +136,18 @@ void part2(const std::vector<std::string>& map) {
     };
 
     size_t treeMult = 1;
-    for (auto& slope : slopes) {
-        size_t x = 0;
-        size_t y = 0;
-        size_t treeCount = 0;
-        while (y < map.size()) {
-            auto& row = map[y];
-            if (row[x] == '#') treeCount++;
-            x = (x + slope.first) % row.size();
-            y += slope.second;
-        }
+    for (auto treeCount : countTrees(map, slopes)) {
         treeMult *= treeCount;
     }
     std::cout << "part 2: " << treeMult << "\n";
 }
 
 auto loadInput() {
-    std::vector<std::string> map;
+    TreeMap map;
     std::ifstream f{ "input.txt" };
-    char line[33];
-    while (f.getline(line, std::size(line))) {
-        map.push_back(line);
+    std::string line;
+    while (std::getline(f, line)) {
+        map.AddRow(line);
     }
     return map;
 }
@@ -1,119 +1,230 @@
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <iostream>
 #include <fstream>
-#include <sstream>
+#include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
-#include <regex>
 
+#include "../common/mapped_file.h"
+#include "../common/record_schema.h"
+#include "../common/records.h"
+
+using u8 = uint8_t;
 using u32 = uint32_t;
-using Passport = std::unordered_map<std::string, std::string>;
+
+// Passport fields, numbered by their slot in the perfect hash below
+enum class Field : u8 { PID, ECL, EYR, HCL, HGT, IYR, CID, BYR };
+
+constexpr std::array<std::string_view, 8> kFieldNames{ "pid", "ecl", "eyr", "hcl", "hgt", "iyr", "cid", "byr" };
+
+// Perfect hash of the eight 3-letter field names into [0, 8)
+constexpr size_t fieldSlot(std::string_view key) {
+    return (((u32)key[0] * 6 + (u32)key[2]) >> 3) & 7;
+}
+
+static_assert([] {
+    for (size_t i = 0; i < kFieldNames.size(); i++) {
+        if (fieldSlot(kFieldNames[i]) != i) return false;
+    }
+    return true;
+}());
+
+constexpr u8 fieldBit(Field field) {
+    return 1 << static_cast<u8>(field);
+}
+
+// Field values are views into the input buffer; present has one bit per field that appeared in the record
+struct Passport {
+    std::array<std::string_view, 8> fields;
+    u8 present = 0;
+
+    void Set(std::string_view key, std::string_view value) {
+        if (key.size() != 3) return;
+        size_t slot = fieldSlot(key);
+        if (kFieldNames[slot] != key) return;
+        fields[slot] = value;
+        present |= 1 << slot;
+    }
+
+    std::string_view Get(Field field) const {
+        return fields[static_cast<size_t>(field)];
+    }
+};
+
+// Every field except cid is required
+constexpr u8 kRequiredFields = 0xFF & ~fieldBit(Field::CID);
 
 bool isValid(const Passport& passport) {
-    return passport.count("byr") > 0
-        && passport.count("iyr") > 0
-        && passport.count("eyr") > 0
-        && passport.count("hgt") > 0
-        && passport.count("hcl") > 0
-        && passport.count("ecl") > 0
-        && passport.count("pid") > 0;
-}
-
-void part1(const std::vector<Passport>& passports) {
-    std::cout << "part 1: " << std::count_if(passports.begin(), passports.end(), isValid) << "\n";
-}
-
-void part2(const std::vector<Passport>& passports) {
-    auto makeYearRangeValidator = [](const std::string key, int min, int max) -> auto {
-        return [=](const Passport& passport) -> bool {
-            std::regex rgx{ "^(\\d{4})$" };
-            std::smatch match;
-            if (std::regex_match(passport.at(key), match, rgx)) {
-                auto yr = std::stoi(match.str());
-                return (yr >= min) && (yr <= max);
-            }
-            return false;
-        };
-    };
-    auto makeHeightValidator = [](const std::string key, int minCM, int maxCM, int minIN, int maxIN) -> auto {
-        return [=](const Passport& passport) -> bool {
-            std::regex rgx{ "^(\\d{3})cm|(\\d{2})in$" };
-            std::smatch match;
-            if (std::regex_match(passport.at(key), match, rgx)) {
-                auto hgtCMStr = match[1].str();
-                auto hgtINStr = match[2].str();
-                if (!hgtCMStr.empty()) {
-                    auto hgt = std::stoi(hgtCMStr);
-                    return (hgt >= minCM) && (hgt <= maxCM);
-                }
-                else if (!hgtINStr.empty()) {
-                    auto hgt = std::stoi(hgtINStr);
-                    return (hgt >= minIN) && (hgt <= maxIN);
-                }
-            }
-            return false;
-        };
-    };
-    auto makeRegexValidator = [](const std::string key, const std::string pattern) -> auto {
-        return [=](const Passport& passport) -> bool {
-            std::regex rgx{ pattern };
-            std::smatch match;
-            return std::regex_match(passport.at(key), match, rgx);
-        };
-    };
+    return (passport.present & kRequiredFields) == kRequiredFields;
+}
+
+constexpr bool isDigit(char ch) {
+    return ch >= '0' && ch <= '9';
+}
+
+constexpr bool isHexDigit(char ch) {
+    return isDigit(ch) || (ch >= 'a' && ch <= 'f');
+}
+
+// Parses exactly `digits` decimal digits starting at value[pos]; returns -1 if any character is not a digit
+constexpr int parseDigits(std::string_view value, size_t pos, size_t digits) {
+    int result = 0;
+    for (size_t i = pos; i < pos + digits; i++) {
+        if (!isDigit(value[i])) return -1;
+        result = result * 10 + (value[i] - '0');
+    }
+    return result;
+}
+
+constexpr bool validYear(std::string_view value, int min, int max) {
+    if (value.size() != 4) return false;
+    int year = parseDigits(value, 0, 4);
+    return year >= min && year <= max;
+}
+
+constexpr bool validHeight(std::string_view value, int minCM, int maxCM, int minIN, int maxIN) {
+    if (value.size() == 5 && value.ends_with("cm")) {
+        int hgt = parseDigits(value, 0, 3);
+        return hgt >= minCM && hgt <= maxCM;
+    }
+    if (value.size() == 4 && value.ends_with("in")) {
+        int hgt = parseDigits(value, 0, 2);
+        return hgt >= minIN && hgt <= maxIN;
+    }
+    return false;
+}
+
+constexpr bool validHairColor(std::string_view value) {
+    return value.size() == 7 && value[0] == '#' && std::all_of(value.begin() + 1, value.end(), isHexDigit);
+}
+
+constexpr bool validEyeColor(std::string_view value) {
+    constexpr std::string_view colors[] = { "amb", "blu", "brn", "gry", "grn", "hzl", "oth" };
+    return std::find(std::begin(colors), std::end(colors), value) != std::end(colors);
+}
+
+constexpr bool validPassportID(std::string_view value) {
+    return value.size() == 9 && std::all_of(value.begin(), value.end(), isDigit);
+}
 
-    auto byrValid = makeYearRangeValidator("byr", 1920, 2002);
-    auto iyrValid = makeYearRangeValidator("iyr", 2010, 2020);
-    auto eyrValid = makeYearRangeValidator("eyr", 2020, 2030);
-    auto hgtValid = makeHeightValidator("hgt", 150, 193, 59, 76);
-    auto hclValid = makeRegexValidator("hcl", "^#[0-9a-f]{6}$");
-    auto eclValid = makeRegexValidator("ecl", "^amb|blu|brn|gry|grn|hzl|oth$");
-    auto pidValid = makeRegexValidator("pid", "^\\d{9}$");
-
-    std::cout << "part 2: " << std::count_if(passports.begin(), passports.end(), [&](const Passport& passport) -> bool {
-        return isValid(passport)
-            && byrValid(passport)
-            && iyrValid(passport)
-            && eyrValid(passport)
-            && hgtValid(passport)
-            && hclValid(passport)
-            && eclValid(passport)
-            && pidValid(passport);
-    }) << "\n";
-}
-
-auto loadInput() {
-    std::vector<Passport> passports;
-    std::ifstream f{ "input.txt" };
-    char line[81];
-    std::unordered_map<std::string, std::string> map;
-    while (f.getline(line, std::size(line))) {
-        if (strlen(line) == 0) {
-            passports.push_back(map);
-            map.clear();
-            continue;
+static_assert(validHeight("60in", 150, 193, 59, 76) && validHeight("190cm", 150, 193, 59, 76));
+static_assert(!validHeight("190in", 150, 193, 59, 76) && !validHeight("190", 150, 193, 59, 76));
+static_assert(validHairColor("#123abc") && !validHairColor("#123abz") && !validHairColor("123abc"));
+static_assert(validPassportID("000000001") && !validPassportID("0123456789"));
+
+bool hasValidFields(const Passport& passport) {
+    return validYear(passport.Get(Field::BYR), 1920, 2002)
+        && validYear(passport.Get(Field::IYR), 2010, 2020)
+        && validYear(passport.Get(Field::EYR), 2020, 2030)
+        && validHeight(passport.Get(Field::HGT), 150, 193, 59, 76)
+        && validHairColor(passport.Get(Field::HCL))
+        && validEyeColor(passport.Get(Field::ECL))
+        && validPassportID(passport.Get(Field::PID));
+}
+
+struct PassportCounts {
+    size_t records = 0;
+    size_t valid1 = 0;
+    size_t valid2 = 0;
+
+    void Merge(const PassportCounts& counts) {
+        records += counts.records;
+        valid1 += counts.valid1;
+        valid2 += counts.valid2;
+    }
+};
+
+// Parses the passports in text and validates each one as soon as its blank line is reached; passports are
+// never stored
+PassportCounts countValidPassports(std::string_view text) {
+    PassportCounts counts;
+    Passport passport;
+    bool inRecord = false;
+    auto finishRecord = [&]() {
+        if (!inRecord) return;
+        counts.records++;
+        if (isValid(passport)) {
+            counts.valid1++;
+            if (hasValidFields(passport)) counts.valid2++;
         }
+        passport = {};
+        inRecord = false;
+    };
 
-        std::istringstream iss{ line };
-        std::string entry;
-        while (iss >> entry) {
-            auto colonPos = entry.find(':');
-            auto key = entry.substr(0, colonPos);
-            auto value = entry.substr(colonPos + 1);
-            map[key] = value;
+    forEachLine(text, [&](std::string_view line) {
+        if (line.empty()) {
+            finishRecord();
+            return;
         }
+        inRecord = true;
+        forEachField(line, ' ', [&](std::string_view entry) {
+            auto colonPos = entry.find(':');
+            if (colonPos == entry.npos) return;
+            passport.Set(entry.substr(0, colonPos), entry.substr(colonPos + 1));
+        });
+    });
+    finishRecord();
+    return counts;
+}
+
+// Memory-maps the file and splits it at blank lines into one chunk per hardware thread. Each thread parses and
+// validates its own passports, and the per-chunk counts are summed.
+PassportCounts countValidPassports(const char* path) {
+    return processChunks<PassportCounts>(path, splitAtBlankLines, [](std::string_view chunk, std::string_view) {
+        return countValidPassports(chunk);
+    });
+}
+
+void part1(const PassportCounts& counts) {
+    std::cout << "part 1: " << counts.valid1 << "\n";
+}
+
+void part2(const PassportCounts& counts) {
+    std::cout << "part 2: " << counts.valid2 << "\n";
+}
+
+// Validates the records in inputPath against a schema file and prints a table of failures per field
+void validateWithSchema(const char* schemaPath, const char* inputPath) {
+    std::ifstream schemaFile{ schemaPath };
+    std::string error;
+    auto schema = RecordSchema::Parse(schemaFile, error);
+    if (!schema) {
+        std::cerr << schemaPath << ": " << error << "\n";
+        return;
     }
-    if (!map.empty()) {
-        passports.push_back(map);
+
+    auto file = loadRecords(inputPath);
+    std::vector<SchemaRecord> records(file.recordCount());
+    for (size_t i = 0; i < file.recordCount(); i++) {
+        for (auto line : file.record(i)) {
+            forEachField(line, ' ', [&](std::string_view entry) {
+                auto colonPos = entry.find(':');
+                if (colonPos == entry.npos) return;
+                schema->SetField(records[i], entry.substr(0, colonPos), entry.substr(colonPos + 1));
+            });
+        }
     }
 
-    return passports;
+    ValidationStats stats;
+    schema->Validate(records, stats);
+    std::cout << "valid: " << stats.valid << " / " << stats.records << "\n";
+    std::cout << "field\tmissing\tinvalid\n";
+    for (size_t i = 0; i < schema->fields.size(); i++) {
+        std::cout << schema->fields[i].name << "\t" << stats.missing[i] << "\t" << stats.invalid[i] << "\n";
+    }
 }
 
-int main() {
-    auto passports = loadInput();
-    part1(passports);
-    part2(passports);
+int main(int argc, char* argv[]) {
+    // day04 --schema <schema file> [input file]
+    if (argc >= 3 && std::string_view{ argv[1] } == "--schema") {
+        validateWithSchema(argv[2], (argc >= 4) ? argv[3] : "input.txt");
+        return 0;
+    }
+
+    auto counts = countValidPassports("input.txt");
+    part1(counts);
+    part2(counts);
     return 0;
 }
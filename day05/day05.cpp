@@ -1,57 +1,271 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <bitset>
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <fstream>
-#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "../common/parallel.h"
+#include "../common/records.h"
+
+using u16 = uint16_t;
 using u32 = uint32_t;
+using u64 = uint64_t;
 
-u32 toID(std::string seat) {
-    u32 id = 0;
-    for (auto ch : seat) {
+// Decodes a seat code into its ID. codeLength is the number of characters in the code; 0 means the length is
+// only known at runtime.
+template <size_t codeLength>
+u64 toID(std::string_view seat) {
+    u64 id = 0;
+    const size_t length = (codeLength != 0) ? codeLength : seat.size();
+    for (size_t i = 0; i < length; i++) {
+        auto ch = seat[i];
         id = (id << 1) | (ch == 'B' || ch == 'R');
     }
     return id;
 }
 
-void part1(const std::vector<std::string>& seats) {
-    u32 maxID = 0;
-    for (auto &seat : seats) {
-        maxID = std::max(maxID, toID(seat));
+// kReverse10[bits] is bits with its low 10 bits in reverse order
+constexpr auto kReverse10 = [] {
+    std::array<u16, 1024> table{};
+    for (u32 bits = 0; bits < 1024; bits++) {
+        for (u32 b = 0; b < 10; b++) {
+            if (bits & (1u << b)) table[bits] |= 1u << (9 - b);
+        }
+    }
+    return table;
+}();
+
+// Decodes every seat code once into a buffer of IDs shared by both parts.
+// With AVX2, 10-character codes are decoded 16 at a time when their lines are evenly spaced in the buffer (one
+// line ending between codes, so a stride of 11 or 12 bytes). Six 32-byte loads cover all 16 lines; testing each
+// byte for 'B'/'R' (the only code characters with bit 2 clear) and taking the movemasks gives one bit per byte, in
+// which code j is the 10 bits at j * stride with its first character lowest. Those bits are reversed with a
+// table lookup. Blocks whose lines aren't evenly spaced are decoded one code at a time.
+template <size_t codeLength>
+std::vector<u64> decodeSeats(const RecordFile& file) {
+    std::vector<u64> ids(file.lines.size());
+    size_t i = 0;
+#if defined(__AVX2__)
+    if constexpr (codeLength == 10) {
+        static constexpr size_t kBatch = 16;
+        static constexpr size_t kLoads = 6;
+        const char* bufferEnd = file.buffer.data() + file.buffer.size();
+        const __m256i bit2 = _mm256_set1_epi8(4);
+        for (; i + kBatch <= ids.size(); i += kBatch) {
+            const char* base = file.lines[i].data();
+            // All six loads must stay inside the buffer
+            if (base + 32 * kLoads > bufferEnd) break;
+            const size_t stride = file.lines[i + 1].data() - base;
+            bool evenlySpaced = (stride <= 12);
+            for (size_t j = 2; j < kBatch; j++) {
+                evenlySpaced &= (file.lines[i + j].data() == base + j * stride);
+            }
+            if (!evenlySpaced) {
+                for (size_t j = 0; j < kBatch; j++) {
+                    ids[i + j] = toID<codeLength>(file.lines[i + j]);
+                }
+                continue;
+            }
+
+            u64 bits[kLoads / 2 + 1] = {};
+            for (size_t load = 0; load < kLoads; load++) {
+                __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + 32 * load));
+                __m256i isSet = _mm256_cmpeq_epi8(_mm256_and_si256(chars, bit2), _mm256_setzero_si256());
+                bits[load / 2] |= u64{ static_cast<u32>(_mm256_movemask_epi8(isSet)) } << (32 * (load % 2));
+            }
+            for (size_t j = 0; j < kBatch; j++) {
+                size_t pos = j * stride;
+                u64 code = bits[pos / 64] >> (pos % 64);
+                if (pos % 64 > 64 - codeLength) {
+                    code |= bits[pos / 64 + 1] << (64 - pos % 64);
+                }
+                ids[i + j] = kReverse10[code & 0x3FF];
+            }
+        }
+    }
+#endif
+    for (; i < ids.size(); i++) {
+        ids[i] = toID<codeLength>(file.lines[i]);
+    }
+    return ids;
+}
+
+void part1(const std::vector<u64>& ids) {
+    u64 maxID = 0;
+    for (auto id : ids) {
+        maxID = std::max(maxID, id);
     }
     std::cout << "part 1: " << maxID << "\n";
 }
 
-void part2(const std::vector<std::string>& seats) {
-    u32 minID = 1024;
-    std::bitset<1024> takenSeats;
-    for (auto& seat : seats) {
-        u32 id = toID(seat);
-        takenSeats.set(id);
-        minID = std::min(minID, id);
+// XOR of all integers in [0, n]
+constexpr u64 xorUpTo(u64 n) {
+    switch (n % 4) {
+    case 0: return n;
+    case 1: return 1;
+    case 2: return n + 1;
+    default: return 0;
     }
-    for (u32 id = minID; id < 1024; id++) {
-        if (!takenSeats.test(id)) {
-            std::cout << "part 2: " << id << "\n";
-            break;
+}
+
+// Sum of all integers in [0, n], modulo 2^64
+constexpr u64 sumUpTo(u64 n) {
+    return (n % 2 == 0) ? (n / 2) * (n + 1) : n * ((n + 1) / 2);
+}
+
+// Bitmap over a large ID space starting at baseID, split into fixed-size shards. Only shards that an ID lands in
+// are stored, keyed by their index relative to baseID, so memory follows the number of IDs and not the size of the
+// range.
+struct ShardedBitmap {
+    static constexpr u64 kShardBits = u64{ 1 } << 20;
+    static constexpr size_t kWordsPerShard = kShardBits / 64;
+    using Shard = std::array<u64, kWordsPerShard>;
+
+    ShardedBitmap(u64 baseID)
+        : baseID(baseID) {
+    }
+
+    u64 baseID;
+    std::unordered_map<u64, std::unique_ptr<Shard>> shards;
+
+    void Set(u64 id) {
+        u64 offset = id - baseID;
+        auto& shard = shards[offset / kShardBits];
+        if (!shard) {
+            shard = std::make_unique<Shard>();
+        }
+        u64 bit = offset % kShardBits;
+        (*shard)[bit / 64] |= u64{ 1 } << (bit % 64);
+    }
+
+    // First clear bit in [begin, end) of the shard, or end if all are set. Whole words are skipped by testing
+    // ~word and locating the first clear bit with countr_zero.
+    u64 FirstClear(u64 shardIndex, u64 begin, u64 end) const {
+        const u64 base = baseID + shardIndex * kShardBits;
+        auto it = shards.find(shardIndex);
+        if (it == shards.end()) return begin;
+        auto& shard = *it->second;
+        for (u64 bit = begin - base; bit < end - base; ) {
+            u64 word = ~shard[bit / 64] & (~u64{ 0 } << (bit % 64));
+            if (word != 0) {
+                return std::min(base + (bit / 64) * 64 + std::countr_zero(word), end);
+            }
+            bit = (bit / 64 + 1) * 64;
         }
+        return end;
     }
+};
+
+// True if no ID in [minID, maxID] appears twice, checked with a flat bitmap of the range
+bool distinctIDs(const std::vector<u64>& ids, u64 minID, u64 maxID) {
+    std::vector<u64> seen((maxID - minID) / 64 + 1);
+    for (auto id : ids) {
+        u64 bit = id - minID;
+        u64 mask = u64{ 1 } << (bit % 64);
+        if (seen[bit / 64] & mask) return false;
+        seen[bit / 64] |= mask;
+    }
+    return true;
 }
 
-auto loadInput() {
-    std::vector<std::string> seats;
-    std::ifstream f{ "input.txt" };
-    std::string seat;
-    while (f >> seat) {
-        seats.push_back(seat);
+// Finds the first ID in [minID, maxID + 1] that is not taken.
+// If exactly one ID is missing from [minID, maxID], the XOR and sum of the range minus those of the IDs both
+// identify it. The candidate is only accepted once the IDs are confirmed to be distinct: repeated IDs can make the
+// XOR and sum agree on a seat that is taken. Otherwise the IDs go into a sharded bitmap whose shards are scanned in
+// parallel, keeping the lowest gap found.
+u64 findFirstGap(const std::vector<u64>& ids, u64 minID, u64 maxID) {
+    if (ids.size() == maxID - minID) {
+        u64 idsXor = 0;
+        u64 idsSum = 0;
+        for (auto id : ids) {
+            idsXor ^= id;
+            idsSum += id;
+        }
+        u64 missingByXor = xorUpTo(maxID) ^ (minID > 0 ? xorUpTo(minID - 1) : 0) ^ idsXor;
+        u64 missingBySum = sumUpTo(maxID) - (minID > 0 ? sumUpTo(minID - 1) : 0) - idsSum;
+        if (missingByXor == missingBySum && missingByXor > minID && missingByXor < maxID
+            && distinctIDs(ids, minID, maxID)) {
+            return missingByXor;
+        }
     }
-    return seats;
+
+    ShardedBitmap takenSeats{ minID };
+    for (auto id : ids) {
+        takenSeats.Set(id);
+    }
+
+    // Each chunk stops at its first gap, and shards that hold no IDs are gaps, so no chunk visits more than
+    // ids.size() + 1 shards however wide the range is
+    const u64 shardCount = (maxID - minID) / ShardedBitmap::kShardBits + 1;
+    std::atomic<u64> firstGap{ maxID + 1 };
+    parallelForRanges(shardCount, [&](size_t, size_t begin, size_t end) {
+        for (u64 shard = begin; shard < end; shard++) {
+            u64 shardBegin = minID + shard * ShardedBitmap::kShardBits;
+            u64 shardEnd = (shard + 1 == shardCount) ? maxID + 1 : shardBegin + ShardedBitmap::kShardBits;
+            if (shardBegin >= firstGap.load()) return;
+            u64 gap = takenSeats.FirstClear(shard, shardBegin, shardEnd);
+            if (gap < shardEnd) {
+                u64 current = firstGap.load();
+                while (gap < current && !firstGap.compare_exchange_weak(current, gap)) {}
+                return;
+            }
+        }
+    });
+    return firstGap;
+}
+
+template <size_t codeLength>
+void part2(const std::vector<u64>& ids) {
+    if (ids.empty()) return;
+    u64 minID = *std::min_element(ids.begin(), ids.end());
+    u64 maxID = *std::max_element(ids.begin(), ids.end());
+
+    if constexpr (codeLength != 0 && codeLength <= 16) {
+        // Small ID spaces fit in a fixed-size bitset
+        constexpr u32 numIDs = 1u << codeLength;
+        std::bitset<numIDs> takenSeats;
+        for (auto id : ids) {
+            takenSeats.set(id);
+        }
+        for (u64 id = minID; id < numIDs; id++) {
+            if (!takenSeats.test(id)) {
+                std::cout << "part 2: " << id << "\n";
+                break;
+            }
+        }
+    }
+    else {
+        std::cout << "part 2: " << findFirstGap(ids, minID, maxID) << "\n";
+    }
+}
+
+auto loadInput() {
+    return loadRecords("input.txt");
 }
 
 int main() {
-    auto seats = loadInput();
-    part1(seats);
-    part2(seats);
+    auto file = loadInput();
+    bool standardCodes = std::all_of(file.lines.begin(), file.lines.end(), [](auto seat) { return seat.size() == 10; });
+    if (standardCodes) {
+        auto ids = decodeSeats<10>(file);
+        part1(ids);
+        part2<10>(ids);
+    }
+    else {
+        auto ids = decodeSeats<0>(file);
+        part1(ids);
+        part2<0>(ids);
+    }
     return 0;
 }
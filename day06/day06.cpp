@@ -1,66 +1,211 @@
-#include <bitset>
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cstdint>
 #include <iostream>
 #include <fstream>
-#include <numeric>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "../common/mapped_file.h"
+#include "../common/records.h"
+
 using u32 = uint32_t;
 
+// Bit i is set if question 'a' + i was answered
 struct Answers {
-    std::bitset<26> any{ 0 };
-    std::bitset<26> all{ ~0ull };
-    
-    void Reset() {
-        any = 0;
-        all = ~0ull;
-    }
+    static constexpr u32 kAllQuestions = (1u << 26) - 1;
+
+    u32 any = 0;
+    u32 all = kAllQuestions;
 };
 
-void part1(const std::vector<Answers>& answers) {
-    u32 total = 0;
-    for (auto &answer : answers) {
-        total += answer.any.count();
+// Converts a line of answers into a letter mask.
+// With AVX2, 8 characters at a time are widened to 32-bit lanes and turned into 1 << (ch - 'a') with a variable
+// shift; lanes past the end of the line shift by 32, which yields 0. The lanes are then OR-reduced.
+// Bytes outside 'a'..'z' contribute nothing on either path.
+// Reading 8 bytes at a time may look past the end of the line, so the vector path only runs when those bytes are
+// still inside the buffer (bufferEnd).
+u32 letterMask(std::string_view line, [[maybe_unused]] const char* bufferEnd) {
+    u32 mask = 0;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i laneIndex = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i letterA = _mm256_set1_epi32('a');
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i outOfRange = _mm256_set1_epi32(32);
+    __m256i bits = _mm256_setzero_si256();
+    for (; i < line.size() && line.data() + i + 8 <= bufferEnd; i += 8) {
+        __m256i chars = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(line.data() + i)));
+        __m256i valid = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(line.size() - i)), laneIndex);
+        __m256i shift = _mm256_blendv_epi8(outOfRange, _mm256_sub_epi32(chars, letterA), valid);
+        bits = _mm256_or_si256(bits, _mm256_sllv_epi32(one, shift));
+    }
+    __m128i bits128 = _mm_or_si128(_mm256_castsi256_si128(bits), _mm256_extracti128_si256(bits, 1));
+    bits128 = _mm_or_si128(bits128, _mm_shuffle_epi32(bits128, _MM_SHUFFLE(1, 0, 3, 2)));
+    bits128 = _mm_or_si128(bits128, _mm_shuffle_epi32(bits128, _MM_SHUFFLE(2, 3, 0, 1)));
+    mask = static_cast<u32>(_mm_cvtsi128_si32(bits128));
+#endif
+    for (; i < line.size(); i++) {
+        if (line[i] >= 'a' && line[i] <= 'z') {
+            mask |= 1u << (line[i] - 'a');
+        }
     }
-    std::cout << "part 1: " << total << "\n";
+    return mask & Answers::kAllQuestions;
 }
 
-void part2(const std::vector<Answers>& answers) {
-    u32 total = 0;
-    for (auto& answer : answers) {
-        total += answer.all.count();
+// Per-question count of group members who answered it, stored as bit-sliced vertical counters: bit i of plane p
+// is bit p of question i's count. Adding a member is a ripple of half adders across the planes, and threshold
+// queries are a bit-serial comparison of all 26 counters at once.
+struct GroupCounter {
+    static constexpr size_t kPlanes = 16;
+
+    std::array<u32, kPlanes> planes{};
+    u32 members = 0;
+
+    void Add(u32 answers) {
+        u32 carry = answers;
+        for (size_t p = 0; p < kPlanes && carry != 0; p++) {
+            u32 nextCarry = planes[p] & carry;
+            planes[p] ^= carry;
+            carry = nextCarry;
+        }
+        members++;
     }
-    std::cout << "part 2: " << total << "\n";
-}
 
-auto loadInput() {
-    std::vector<Answers> answers;
-    std::ifstream f{ "input.txt" };
-    std::string line;
+    // Mask of questions answered by at least k members
+    u32 AtLeast(u32 k) const {
+        if (k >> kPlanes) return 0;
+        u32 greater = 0;
+        u32 equal = Answers::kAllQuestions;
+        for (size_t p = kPlanes; p-- > 0; ) {
+            if ((k >> p) & 1) {
+                equal &= planes[p];
+            }
+            else {
+                greater |= equal & planes[p];
+                equal &= ~planes[p];
+            }
+        }
+        return greater | equal;
+    }
+
+    // Adds each question's member count to histogram
+    void AddTo(std::array<size_t, 26>& histogram) const {
+        for (size_t p = 0; p < kPlanes; p++) {
+            for (u32 bits = planes[p]; bits != 0; bits &= bits - 1) {
+                histogram[std::countr_zero(bits)] += size_t{ 1 } << p;
+            }
+        }
+    }
+};
+
+struct AnswerCounts {
+    size_t any = 0;
+    size_t all = 0;
+
+    // Optional queries: for each threshold, the number of (group, question) pairs answered by at least that many
+    // members of the group, and the total number of answers per question across all groups
+    std::vector<size_t> atLeast;
+    std::array<size_t, 26> questionTotals{};
+
+    void Merge(const AnswerCounts& counts) {
+        any += counts.any;
+        all += counts.all;
+        atLeast.resize(std::max(atLeast.size(), counts.atLeast.size()));
+        for (size_t i = 0; i < counts.atLeast.size(); i++) {
+            atLeast[i] += counts.atLeast[i];
+        }
+        for (size_t q = 0; q < questionTotals.size(); q++) {
+            questionTotals[q] += counts.questionTotals[q];
+        }
+    }
+};
+
+// Folds every group in text into its any/all masks and sums their popcounts; groups are never stored.
+// If thresholds are given, groups are also tallied with bit-sliced counters to answer "at least k members" queries
+// and to build the per-question histogram.
+AnswerCounts countAnswers(std::string_view text, const char* bufferEnd, std::span<const u32> thresholds) {
+    AnswerCounts counts;
+    counts.atLeast.resize(thresholds.size());
+    const bool countMembers = !thresholds.empty();
     Answers groupAnswers;
-    while (std::getline(f, line)) {
-        if (line.empty()) {
-            answers.push_back(groupAnswers);
-            groupAnswers.Reset();
-            continue;
+    GroupCounter groupCounter;
+    bool inGroup = false;
+    auto finishGroup = [&]() {
+        if (!inGroup) return;
+        counts.any += std::popcount(groupAnswers.any);
+        counts.all += std::popcount(groupAnswers.all);
+        if (countMembers) {
+            for (size_t i = 0; i < thresholds.size(); i++) {
+                counts.atLeast[i] += std::popcount(groupCounter.AtLeast(thresholds[i]));
+            }
+            groupCounter.AddTo(counts.questionTotals);
+            groupCounter = {};
         }
-        std::bitset<26> personAnswers;
-        for (char c : line) {
-            personAnswers.set(c - 'a');
+        groupAnswers = {};
+        inGroup = false;
+    };
+
+    forEachLine(text, [&](std::string_view line) {
+        if (line.empty()) {
+            finishGroup();
+            return;
         }
+        inGroup = true;
+        u32 personAnswers = letterMask(line, bufferEnd);
         groupAnswers.any |= personAnswers;
         groupAnswers.all &= personAnswers;
-    }
-    if (groupAnswers.any.any()) {
-        answers.push_back(groupAnswers);
-    }
-    return answers;
+        if (countMembers) {
+            groupCounter.Add(personAnswers);
+        }
+    });
+    finishGroup();
+    return counts;
+}
+
+// Memory-maps the file and splits it at blank lines into one chunk of groups per hardware thread; the per-chunk
+// counts are summed
+AnswerCounts countAnswers(const char* path, std::span<const u32> thresholds = {}) {
+    return processChunks<AnswerCounts>(path, splitAtBlankLines, [&](std::string_view chunk, std::string_view text) {
+        return countAnswers(chunk, text.data() + text.size(), thresholds);
+    });
+}
+
+void part1(const AnswerCounts& counts) {
+    std::cout << "part 1: " << counts.any << "\n";
+}
+
+void part2(const AnswerCounts& counts) {
+    std::cout << "part 2: " << counts.all << "\n";
 }
 
-int main() {
-    auto answers = loadInput();
-    part1(answers);
-    part2(answers);
+int main(int argc, char* argv[]) {
+    // day06 --at-least <k> [<k> ...]
+    if (argc >= 3 && std::string_view{ argv[1] } == "--at-least") {
+        std::vector<u32> thresholds;
+        for (int i = 2; i < argc; i++) {
+            thresholds.push_back(std::stoul(argv[i]));
+        }
+        auto counts = countAnswers("input.txt", thresholds);
+        for (size_t i = 0; i < thresholds.size(); i++) {
+            std::cout << "at least " << thresholds[i] << ": " << counts.atLeast[i] << "\n";
+        }
+        std::cout << "question\tanswers\n";
+        for (size_t q = 0; q < counts.questionTotals.size(); q++) {
+            std::cout << static_cast<char>('a' + q) << "\t" << counts.questionTotals[q] << "\n";
+        }
+        return 0;
+    }
+
+    auto counts = countAnswers("input.txt");
+    part1(counts);
+    part2(counts);
     return 0;
 }
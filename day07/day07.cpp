@@ -1,84 +1,553 @@
+#include <algorithm>
+#include <bit>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
-#include <regex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
-#include <unordered_set>
-#include <deque>
+#include <vector>
+
+#include "../common/mapped_file.h"
+#include "../common/parallel.h"
 
 using u32 = uint32_t;
+using u64 = uint64_t;
 
 struct Rule {
     u32 count;
-    std::string color;
+    u32 color;
 };
 
-struct Rules {
+// Lets color lookups take a string_view without building a std::string
+struct ColorHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view color) const {
+        return std::hash<std::string_view>{}(color);
+    }
+};
+
+using ColorIDs = std::unordered_map<std::string, u32, ColorHash, std::equal_to<>>;
+
+// Bag rules with colors interned into dense IDs. Edges are stored in compressed sparse row form: the edges of
+// color c are edges[start[c]] up to edges[start[c + 1]].
+struct BagGraph {
+    std::vector<std::string> colors;
+    ColorIDs colorIDs;
+
     // What bags can a bag of a given color contain
-    std::unordered_multimap<std::string, Rule> forward;
+    std::vector<u32> forwardStart;
+    std::vector<Rule> forward;
 
     // What bags can contain a bag of a given color
-    std::unordered_multimap<std::string, std::string> backward;
+    std::vector<u32> backwardStart;
+    std::vector<u32> backward;
+
+    // Total number of bags in a bag of each color, counting the bag itself
+    std::vector<u64> totalBags;
+
+    u32 Intern(std::string_view color) {
+        if (auto it = colorIDs.find(color); it != colorIDs.end()) {
+            return it->second;
+        }
+        u32 id = ColorCount();
+        colorIDs.emplace(color, id);
+        colors.emplace_back(color);
+        return id;
+    }
+
+    u32 Find(const std::string& color) const {
+        return colorIDs.at(color);
+    }
+
+    u32 ColorCount() const {
+        return static_cast<u32>(colors.size());
+    }
+
+    struct EdgeList {
+        std::vector<u32> containers;
+        std::vector<Rule> rules;
+    };
+
+    // Builds both CSR arrays from an edge list with a counting sort, then computes the bag totals
+    void Build(const EdgeList& edges) {
+        const u32 colorCount = ColorCount();
+        forwardStart.assign(colorCount + 1, 0);
+        backwardStart.assign(colorCount + 1, 0);
+        for (size_t i = 0; i < edges.rules.size(); i++) {
+            forwardStart[edges.containers[i] + 1]++;
+            backwardStart[edges.rules[i].color + 1]++;
+        }
+        for (u32 c = 0; c < colorCount; c++) {
+            forwardStart[c + 1] += forwardStart[c];
+            backwardStart[c + 1] += backwardStart[c];
+        }
+        forward.resize(edges.rules.size());
+        backward.resize(edges.rules.size());
+        std::vector<u32> forwardPos{ forwardStart.begin(), forwardStart.end() - 1 };
+        std::vector<u32> backwardPos{ backwardStart.begin(), backwardStart.end() - 1 };
+        for (size_t i = 0; i < edges.rules.size(); i++) {
+            auto container = edges.containers[i];
+            auto& rule = edges.rules[i];
+            forward[forwardPos[container]++] = rule;
+            backward[backwardPos[rule.color]++] = container;
+        }
+
+        ComputeTotalBags();
+    }
+
+    // Colors ordered so that every bag comes before the bags it contains (Kahn's algorithm). Colors that are part
+    // of a containment cycle are left out.
+    std::vector<u32> TopologicalOrder() const {
+        const u32 colorCount = ColorCount();
+        std::vector<u32> inDegree(colorCount);
+        for (auto& rule : forward) {
+            inDegree[rule.color]++;
+        }
+        std::vector<u32> order;
+        order.reserve(colorCount);
+        for (u32 c = 0; c < colorCount; c++) {
+            if (inDegree[c] == 0) order.push_back(c);
+        }
+        for (size_t i = 0; i < order.size(); i++) {
+            u32 c = order[i];
+            for (u32 e = forwardStart[c]; e < forwardStart[c + 1]; e++) {
+                if (--inDegree[forward[e].color] == 0) order.push_back(forward[e].color);
+            }
+        }
+        return order;
+    }
+
+    // Every color's total is computed once, level by level: a color's level is the length of the longest chain of
+    // bags inside it, so all bags it contains are at lower levels and each level can be computed in parallel
+    void ComputeTotalBags() {
+        static constexpr size_t kMinParallelLevelSize = 4096;
+
+        auto order = TopologicalOrder();
+        std::vector<u32> level(ColorCount());
+        u32 maxLevel = 0;
+        for (auto it = order.rbegin(); it != order.rend(); it++) {
+            u32 c = *it;
+            for (u32 e = forwardStart[c]; e < forwardStart[c + 1]; e++) {
+                level[c] = std::max(level[c], level[forward[e].color] + 1);
+            }
+            maxLevel = std::max(maxLevel, level[c]);
+        }
+        std::vector<std::vector<u32>> levels(order.empty() ? 0 : maxLevel + 1);
+        for (u32 c : order) {
+            levels[level[c]].push_back(c);
+        }
+
+        totalBags.assign(ColorCount(), 0);
+        auto computeTotals = [&](const std::vector<u32>& colorsInLevel, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                u32 c = colorsInLevel[i];
+                u64 total = 1;
+                for (u32 e = forwardStart[c]; e < forwardStart[c + 1]; e++) {
+                    total += forward[e].count * totalBags[forward[e].color];
+                }
+                totalBags[c] = total;
+            }
+        };
+        for (auto& colorsInLevel : levels) {
+            if (colorsInLevel.size() < kMinParallelLevelSize) {
+                computeTotals(colorsInLevel, 0, colorsInLevel.size());
+            }
+            else {
+                parallelForRanges(colorsInLevel.size(), [&](size_t, size_t begin, size_t end) {
+                    computeTotals(colorsInLevel, begin, end);
+                });
+            }
+        }
+    }
 };
 
-void part1(const Rules& rules) {
-    std::deque<std::string> bagsToCheck;
-    std::unordered_set<std::string> bagsThatContainIt;
-    auto range = rules.backward.equal_range("shiny gold");
-    for (auto it = range.first; it != range.second; it++) {
-        bagsToCheck.push_back(it->second);
+// For every color: how many colors can eventually contain it, and how many bags it contains
+struct ColorStats {
+    std::vector<u64> ancestorCounts;
+    std::vector<u64> insideCounts;
+};
+
+// Ancestor counts come from a blocked transitive closure. Colors are taken 64 at a time in topological order;
+// for each block, one sweep in topological order propagates a 64-bit mask of the block colors that reach each
+// color, and the popcount of each mask is added to that color's ancestor count. Colors before the block can't
+// be reached from it, so each sweep starts at the block. Blocks are independent and are spread across threads.
+ColorStats computeColorStats(const BagGraph& graph) {
+    const u32 colorCount = graph.ColorCount();
+    ColorStats stats;
+    stats.insideCounts.resize(colorCount);
+    for (u32 c = 0; c < colorCount; c++) {
+        stats.insideCounts[c] = (graph.totalBags[c] > 0) ? graph.totalBags[c] - 1 : 0;
     }
-    while (!bagsToCheck.empty()) {
-        auto bag = bagsToCheck.front();
-        bagsToCheck.pop_front();
-        bagsThatContainIt.insert(bag);
-        auto range = rules.backward.equal_range(bag);
-        for (auto it = range.first; it != range.second; it++) {
-            bagsToCheck.push_back(it->second);
+
+    auto order = graph.TopologicalOrder();
+    std::vector<u32> position(colorCount, ~0u);
+    for (u32 i = 0; i < order.size(); i++) {
+        position[order[i]] = i;
+    }
+
+    const size_t blockCount = (order.size() + 63) / 64;
+    std::vector<std::vector<u64>> threadAncestorCounts(hardwareThreads());
+    size_t chunkCount = parallelForRanges(blockCount, [&](size_t chunk, size_t beginBlock, size_t endBlock) {
+        auto& ancestorCounts = threadAncestorCounts[chunk];
+        ancestorCounts.assign(colorCount, 0);
+        std::vector<u64> reach(colorCount);
+        for (size_t block = beginBlock; block < endBlock; block++) {
+            const size_t blockBegin = block * 64;
+            const size_t blockEnd = std::min(blockBegin + 64, order.size());
+            for (size_t i = blockBegin; i < order.size(); i++) {
+                u32 c = order[i];
+                u64 mask = 0;
+                for (u32 e = graph.backwardStart[c]; e < graph.backwardStart[c + 1]; e++) {
+                    u32 container = graph.backward[e];
+                    u32 containerPos = position[container];
+                    if (containerPos < blockBegin) continue;
+                    mask |= reach[container];
+                    if (containerPos < blockEnd) {
+                        mask |= u64{ 1 } << (containerPos - blockBegin);
+                    }
+                }
+                reach[c] = mask;
+                ancestorCounts[c] += std::popcount(mask);
+            }
+        }
+    });
+
+    stats.ancestorCounts.assign(colorCount, 0);
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        for (u32 c = 0; c < colorCount; c++) {
+            stats.ancestorCounts[c] += threadAncestorCounts[chunk][c];
         }
     }
-    std::cout << "part 1: " << bagsThatContainIt.size() << "\n";
+    return stats;
 }
 
-size_t countContainedBags(const Rules& rules, std::string bag) {
-    size_t total = 1;
-    auto range = rules.forward.equal_range(bag);
-    for (auto it = range.first; it != range.second; it++) {
-        total += it->second.count * countContainedBags(rules, it->second.color);
+// Bag rules that can be added and removed one at a time. Bag totals and container sets are memoized per color and
+// filled in on demand; an edit only invalidates the memos it can affect and stops at memos that are already invalid.
+// A total depends on the totals of the bags inside it, so a valid total implies valid totals below it, and an edit
+// to a container's rules walks up through the colors that can hold it. A container set is the union of the sets of
+// the direct containers, so a valid set implies valid sets above it, and an edit walks down from the contained color.
+struct DynamicBagGraph {
+    std::vector<std::string> colors;
+    ColorIDs colorIDs;
+    std::vector<std::vector<Rule>> forward;
+    std::vector<std::vector<u32>> backward;
+
+    std::vector<u64> totalBags;
+    std::vector<bool> totalValid;
+
+    // Bitset of the colors that can eventually contain each color
+    std::vector<std::vector<u64>> containerSets;
+    std::vector<bool> containersValid;
+
+    DynamicBagGraph(const BagGraph& graph)
+        : colors(graph.colors), colorIDs(graph.colorIDs), forward(graph.ColorCount()), backward(graph.ColorCount()),
+          totalBags(graph.totalBags), totalValid(graph.ColorCount(), true), containerSets(graph.ColorCount()),
+          containersValid(graph.ColorCount(), false) {
+        if (graph.TopologicalOrder().size() != graph.ColorCount()) {
+            // The rules contain a cycle
+            std::abort();
+        }
+        for (u32 c = 0; c < graph.ColorCount(); c++) {
+            auto forwardBegin = graph.forward.begin();
+            auto backwardBegin = graph.backward.begin();
+            forward[c].assign(forwardBegin + graph.forwardStart[c], forwardBegin + graph.forwardStart[c + 1]);
+            backward[c].assign(backwardBegin + graph.backwardStart[c], backwardBegin + graph.backwardStart[c + 1]);
+        }
+    }
+
+    u32 Intern(std::string_view color) {
+        auto [it, inserted] = colorIDs.try_emplace(std::string{ color }, static_cast<u32>(colors.size()));
+        if (inserted) {
+            colors.emplace_back(color);
+            forward.emplace_back();
+            backward.emplace_back();
+            totalBags.push_back(1);
+            totalValid.push_back(true);
+            containerSets.emplace_back();
+            containersValid.push_back(false);
+        }
+        return it->second;
+    }
+
+    u32 Find(const std::string& color) const {
+        return colorIDs.at(color);
     }
-    return total;
+
+    // Sets how many bags of color `contained` a bag of color `container` holds, adding the rule if needed.
+    // Returns false and leaves the graph unchanged if the rule would let a bag contain itself.
+    bool AddRule(std::string_view container, u32 count, std::string_view contained) {
+        u32 outer = Intern(container);
+        u32 inner = Intern(contained);
+        auto& rules = forward[outer];
+        auto rule = std::find_if(rules.begin(), rules.end(), [&](auto& r) { return r.color == inner; });
+        if (rule != rules.end()) {
+            rule->count = count;
+            InvalidateTotals(outer);
+            return true;
+        }
+        if (Contains(inner, outer)) return false;
+        rules.push_back({ count, inner });
+        backward[inner].push_back(outer);
+        InvalidateTotals(outer);
+        InvalidateContainers(inner);
+        return true;
+    }
+
+    // Returns false if there was no such rule
+    bool RemoveRule(std::string_view container, std::string_view contained) {
+        auto outer = colorIDs.find(container);
+        auto inner = colorIDs.find(contained);
+        if (outer == colorIDs.end() || inner == colorIDs.end()) return false;
+        auto& rules = forward[outer->second];
+        auto rule = std::find_if(rules.begin(), rules.end(), [&](auto& r) { return r.color == inner->second; });
+        if (rule == rules.end()) return false;
+        rules.erase(rule);
+        auto& containers = backward[inner->second];
+        containers.erase(std::find(containers.begin(), containers.end(), outer->second));
+        InvalidateTotals(outer->second);
+        InvalidateContainers(inner->second);
+        return true;
+    }
+
+    // True if a bag of color outer can eventually contain a bag of color inner (or they are the same color).
+    // The search only visits bags inside outer.
+    bool Contains(u32 outer, u32 inner) const {
+        std::vector<bool> visited(colors.size());
+        std::vector<u32> bagsToCheck{ outer };
+        visited[outer] = true;
+        while (!bagsToCheck.empty()) {
+            u32 bag = bagsToCheck.back();
+            bagsToCheck.pop_back();
+            if (bag == inner) return true;
+            for (auto& rule : forward[bag]) {
+                if (!visited[rule.color]) {
+                    visited[rule.color] = true;
+                    bagsToCheck.push_back(rule.color);
+                }
+            }
+        }
+        return false;
+    }
+
+    // Total number of bags in a bag of the given color, counting the bag itself. Invalid totals below it are
+    // recomputed in post-order.
+    u64 TotalBags(u32 color) {
+        std::vector<std::pair<u32, size_t>> stack{ { color, 0 } };
+        while (!stack.empty()) {
+            auto& [bag, next] = stack.back();
+            if (totalValid[bag]) {
+                stack.pop_back();
+                continue;
+            }
+            if (next < forward[bag].size()) {
+                stack.push_back({ forward[bag][next++].color, 0 });
+                continue;
+            }
+            u64 total = 1;
+            for (auto& rule : forward[bag]) {
+                total += rule.count * totalBags[rule.color];
+            }
+            totalBags[bag] = total;
+            totalValid[bag] = true;
+            stack.pop_back();
+        }
+        return totalBags[color];
+    }
+
+    // Number of colors that can eventually contain a bag of the given color. Invalid container sets above it are
+    // recomputed in post-order.
+    size_t ContainerCount(u32 color) {
+        std::vector<std::pair<u32, size_t>> stack{ { color, 0 } };
+        while (!stack.empty()) {
+            auto& [bag, next] = stack.back();
+            if (containersValid[bag]) {
+                stack.pop_back();
+                continue;
+            }
+            if (next < backward[bag].size()) {
+                stack.push_back({ backward[bag][next++], 0 });
+                continue;
+            }
+            auto& containers = containerSets[bag];
+            containers.assign((colors.size() + 63) / 64, 0);
+            for (u32 outer : backward[bag]) {
+                auto& outerContainers = containerSets[outer];
+                for (size_t w = 0; w < outerContainers.size(); w++) {
+                    containers[w] |= outerContainers[w];
+                }
+                containers[outer / 64] |= u64{ 1 } << (outer % 64);
+            }
+            containersValid[bag] = true;
+            stack.pop_back();
+        }
+        size_t count = 0;
+        for (u64 word : containerSets[color]) {
+            count += std::popcount(word);
+        }
+        return count;
+    }
+
+private:
+    void InvalidateTotals(u32 color) {
+        std::vector<u32> bagsToCheck{ color };
+        while (!bagsToCheck.empty()) {
+            u32 bag = bagsToCheck.back();
+            bagsToCheck.pop_back();
+            if (!totalValid[bag]) continue;
+            totalValid[bag] = false;
+            bagsToCheck.insert(bagsToCheck.end(), backward[bag].begin(), backward[bag].end());
+        }
+    }
+
+    void InvalidateContainers(u32 color) {
+        std::vector<u32> bagsToCheck{ color };
+        while (!bagsToCheck.empty()) {
+            u32 bag = bagsToCheck.back();
+            bagsToCheck.pop_back();
+            if (!containersValid[bag]) continue;
+            containersValid[bag] = false;
+            for (auto& rule : forward[bag]) {
+                bagsToCheck.push_back(rule.color);
+            }
+        }
+    }
+};
+
+void part1(const BagGraph& graph) {
+    std::vector<bool> visited(graph.ColorCount());
+    std::vector<u32> bagsToCheck{ graph.Find("shiny gold") };
+    visited[bagsToCheck[0]] = true;
+    size_t bagsThatContainIt = 0;
+    while (!bagsToCheck.empty()) {
+        u32 bag = bagsToCheck.back();
+        bagsToCheck.pop_back();
+        for (u32 e = graph.backwardStart[bag]; e < graph.backwardStart[bag + 1]; e++) {
+            u32 container = graph.backward[e];
+            if (!visited[container]) {
+                visited[container] = true;
+                bagsThatContainIt++;
+                bagsToCheck.push_back(container);
+            }
+        }
+    }
+    std::cout << "part 1: " << bagsThatContainIt << "\n";
 }
 
-void part2(const Rules& rules) {
-    std::cout << "part 2: " << (countContainedBags(rules, "shiny gold") - 1) << "\n";
+void part2(const BagGraph& graph) {
+    std::cout << "part 2: " << (graph.totalBags[graph.Find("shiny gold")] - 1) << "\n";
 }
 
-auto loadInput() {
-    std::ifstream f{ "input.txt" };
+void applyEdits(const BagGraph& graph, const char* path) {
+    DynamicBagGraph rules{ graph };
+    u32 gold = rules.Find("shiny gold");
+    std::ifstream f{ path };
     std::string line;
-    std::regex rgxEntry{ "(\\d+) (.*?) bags?" };
-    std::smatch match;
-    Rule rule;
-    Rules rules;
     while (std::getline(f, line)) {
-        auto containPos = line.find(" bags contain ");
-        auto container = line.substr(0, containPos);
-        auto contained = line.substr(containPos + 14);
-        auto pos = contained.cbegin();
-        while (std::regex_search(pos, contained.cend(), match, rgxEntry)) {
-            rule = { std::stoul(match[1]), match[2] };
-            rules.forward.emplace(std::make_pair(container, rule));
-            rules.backward.emplace(std::make_pair(rule.color, container));
-            pos = match.suffix().first;
-        }
-    }
-    return rules;
+        std::string_view edit{ line };
+        bool applied = false;
+        if (edit.starts_with("add ")) {
+            edit.remove_prefix(4);
+            auto countEnd = edit.find(' ');
+            auto toPos = edit.find(" to ");
+            if (countEnd != edit.npos && toPos != edit.npos && countEnd < toPos) {
+                u32 count = static_cast<u32>(std::stoul(std::string{ edit.substr(0, countEnd) }));
+                applied = rules.AddRule(edit.substr(toPos + 4), count, edit.substr(countEnd + 1, toPos - countEnd - 1));
+            }
+        }
+        else if (edit.starts_with("remove ")) {
+            edit.remove_prefix(7);
+            auto fromPos = edit.find(" from ");
+            if (fromPos != edit.npos) {
+                applied = rules.RemoveRule(edit.substr(fromPos + 6), edit.substr(0, fromPos));
+            }
+        }
+        std::cout << line << (applied ? "" : " (rejected)") << ": " << rules.ContainerCount(gold) << " "
+            << (rules.TotalBags(gold) - 1) << "\n";
+    }
+}
+
+// Parses "<color> bags contain <N> <color> bag(s), ... ." and "<color> bags contain no other bags." lines in one
+// pass over text, interning colors as they are found and appending one edge per contained color
+void parseRules(std::string_view text, BagGraph& graph, BagGraph::EdgeList& edges) {
+    const char* pos = text.data();
+    const char* end = text.data() + text.size();
+    auto startsWith = [&](std::string_view word) {
+        return static_cast<size_t>(end - pos) >= word.size() && std::memcmp(pos, word.data(), word.size()) == 0;
+    };
+    // A color is every word up to " bag"; pos is left after "bag" or "bags"
+    auto readColor = [&]() {
+        const char* color = pos;
+        while (pos < end && *pos != '\n' && !startsWith(" bag")) {
+            pos++;
+        }
+        std::string_view name{ color, static_cast<size_t>(pos - color) };
+        pos = std::min(pos + 4, end);
+        if (pos < end && *pos == 's') pos++;
+        return name;
+    };
+    auto skipLine = [&]() {
+        auto newline = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+        pos = (newline != nullptr) ? newline + 1 : end;
+    };
+
+    while (pos < end) {
+        if (*pos == '\n' || *pos == '\r') {
+            pos++;
+            continue;
+        }
+        u32 container = graph.Intern(readColor());
+        if (startsWith(" contain ")) {
+            pos += 9;
+            while (pos < end && *pos >= '0' && *pos <= '9') {
+                u32 count = 0;
+                while (pos < end && *pos >= '0' && *pos <= '9') {
+                    count = count * 10 + (*pos++ - '0');
+                }
+                pos++; // ' '
+                edges.containers.push_back(container);
+                edges.rules.push_back({ count, graph.Intern(readColor()) });
+                if (startsWith(", ")) pos += 2;
+            }
+        }
+        skipLine();
+    }
+}
+
+auto loadInput() {
+    MappedFile file{ "input.txt" };
+    BagGraph graph;
+    BagGraph::EdgeList edges;
+    parseRules(file.text(), graph, edges);
+    graph.Build(edges);
+    return graph;
 }
 
-int main() {
-    auto rules = loadInput();
-    part1(rules);
-    part2(rules);
+int main(int argc, char* argv[]) {
+    auto graph = loadInput();
+
+    // day07 --edit <edit file>
+    // Each line is "add <count> <contained color> to <container color>" or "remove <contained color> from
+    // <container color>"; the shiny gold answers are printed after every edit
+    if (argc >= 3 && std::string_view{ argv[1] } == "--edit") {
+        applyEdits(graph, argv[2]);
+        return 0;
+    }
+
+    // day07 --all-colors
+    if (argc >= 2 && std::string_view{ argv[1] } == "--all-colors") {
+        auto stats = computeColorStats(graph);
+        std::cout << "color\tcontainers\tinside\n";
+        for (u32 c = 0; c < graph.ColorCount(); c++) {
+            std::cout << graph.colors[c] << "\t" << stats.ancestorCounts[c] << "\t" << stats.insideCounts[c] << "\n";
+        }
+        return 0;
+    }
+
+    part1(graph);
+    part2(graph);
     return 0;
 }
@@ -1,10 +1,18 @@
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <iostream>
 #include <fstream>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "../common/parallel.h"
+
 using s32 = int32_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
 
 struct Instruction {
     enum class Opcode { Acc, Jmp, Nop };
@@ -12,25 +20,85 @@ struct Instruction {
     s32 argument;
 };
 
+// Profiling policy for Interpreter that records nothing; every hook compiles away
+struct NoProfiler {
+    void Reset(size_t) {}
+    void OnExecute(size_t, s32) {}
+    void OnJump(size_t) {}
+    void OnLoop(size_t, s32) {}
+};
+
+// Profiling policy for Interpreter that records how often each instruction ran and how often each jmp was taken.
+// The step and accumulator at each instruction's first run identify the detected infinite loop: it starts at the
+// instruction about to run again and spans every step since that instruction's first run.
+struct ExecutionProfiler {
+    struct Loop {
+        size_t entry;
+        u64 length;
+        s32 accDelta;
+    };
+
+    std::vector<u64> counts;
+    std::vector<u64> jumps;
+    std::vector<u64> firstStep;
+    std::vector<s32> firstAcc;
+    u64 steps = 0;
+    std::optional<Loop> loop;
+
+    void Reset(size_t programSize) {
+        counts.assign(programSize, 0);
+        jumps.assign(programSize, 0);
+        firstStep.assign(programSize, 0);
+        firstAcc.assign(programSize, 0);
+        steps = 0;
+        loop.reset();
+    }
+
+    void OnExecute(size_t pc, s32 acc) {
+        if (counts[pc]++ == 0) {
+            firstStep[pc] = steps;
+            firstAcc[pc] = acc;
+        }
+        steps++;
+    }
+
+    void OnJump(size_t pc) {
+        jumps[pc]++;
+    }
+
+    void OnLoop(size_t pc, s32 acc) {
+        loop = Loop{ pc, steps - firstStep[pc], acc - firstAcc[pc] };
+    }
+
+    bool InLoop(size_t pc) const {
+        return loop && counts[pc] > 0 && firstStep[pc] >= firstStep[loop->entry];
+    }
+};
+
+template <typename Profiler = NoProfiler>
 struct Interpreter {
     Interpreter(const std::vector<Instruction>& program)
         : program(program.begin(), program.end()) {
         visited.resize(program.size());
+        profiler.Reset(program.size());
     }
 
     Interpreter(const Interpreter& interpreter)
         : program(interpreter.program.begin(), interpreter.program.end())
         , visited(interpreter.visited.begin(), interpreter.visited.end())
         , acc(interpreter.acc)
-        , pc(interpreter.pc) {
+        , pc(interpreter.pc)
+        , profiler(interpreter.profiler) {
     }
 
     std::vector<Instruction> program;
     std::vector<bool> visited;
     s32 acc = 0;
     size_t pc = 0;
+    // Takes no space with NoProfiler
+    [[no_unique_address]] Profiler profiler;
 
-    void Reset() { acc = 0; pc = 0; std::fill(visited.begin(), visited.end(), false); }
+    void Reset() { acc = 0; pc = 0; std::fill(visited.begin(), visited.end(), false); profiler.Reset(program.size()); }
 
     Instruction CurrentInstruction() {
         // could be out-of-bounds!
@@ -61,13 +129,15 @@ struct Interpreter {
         auto& instr = program[pc];
 
         if (visited[pc]) {
+            profiler.OnLoop(pc, acc);
             return false;
         }
         visited[pc] = true;
+        profiler.OnExecute(pc, acc);
 
         switch (instr.opcode) {
         case Instruction::Opcode::Acc: acc += instr.argument; pc++; break;
-        case Instruction::Opcode::Jmp: pc += instr.argument; break;
+        case Instruction::Opcode::Jmp: profiler.OnJump(pc); pc += instr.argument; break;
         case Instruction::Opcode::Nop: pc++; break;
         }
 
@@ -79,33 +149,328 @@ struct Interpreter {
     }
 };
 
+// Where control goes after instruction pc; any target outside the program ends it
+size_t successor(const Instruction& instr, size_t pc) {
+    return (instr.opcode == Instruction::Opcode::Jmp) ? pc + instr.argument : pc + 1;
+}
+
+Instruction flipped(Instruction instr) {
+    switch (instr.opcode) {
+    case Instruction::Opcode::Jmp: instr.opcode = Instruction::Opcode::Nop; break;
+    case Instruction::Opcode::Nop: instr.opcode = Instruction::Opcode::Jmp; break;
+    case Instruction::Opcode::Acc: break;
+    }
+    return instr;
+}
+
+// Program compiled into basic blocks. A block starts at pc 0, at every jump target and after every jmp; its acc
+// instructions are folded into one delta, nops disappear and the jmp (or fall-through) at its end becomes the index
+// of the next block. Running it is then one add and one load per block, with no opcode dispatch left, and loops are
+// detected per block: control can only re-enter code it has run at the start of a block.
+// Visited marks are stamped with a per-run epoch so the program can be run many times without clearing them.
+struct BlockProgram {
+    static constexpr u32 kExit = ~0u;
+
+    struct Block {
+        s32 accDelta;
+        u32 next;
+    };
+
+    std::vector<Block> blocks;
+    std::vector<u32> visitedEpoch;
+    u32 epoch = 0;
+
+    BlockProgram(const std::vector<Instruction>& program) {
+        const size_t size = program.size();
+        std::vector<u32> blockAt(size + 1, kExit);
+        auto markLeader = [&](size_t pc) {
+            if (pc < size) blockAt[pc] = 0;
+        };
+        markLeader(0);
+        for (size_t pc = 0; pc < size; pc++) {
+            if (program[pc].opcode == Instruction::Opcode::Jmp) {
+                markLeader(successor(program[pc], pc));
+                markLeader(pc + 1);
+            }
+        }
+        std::vector<size_t> leaders;
+        for (size_t pc = 0; pc < size; pc++) {
+            if (blockAt[pc] != kExit) {
+                blockAt[pc] = static_cast<u32>(leaders.size());
+                leaders.push_back(pc);
+            }
+        }
+
+        blocks.resize(leaders.size());
+        for (size_t b = 0; b < leaders.size(); b++) {
+            s32 accDelta = 0;
+            size_t pc = leaders[b];
+            size_t next = pc;
+            for (;;) {
+                auto& instr = program[pc];
+                if (instr.opcode == Instruction::Opcode::Acc) accDelta += instr.argument;
+                next = successor(instr, pc);
+                if (instr.opcode == Instruction::Opcode::Jmp || next >= size || blockAt[next] != kExit) break;
+                pc = next;
+            }
+            blocks[b] = { accDelta, (next < size) ? blockAt[next] : kExit };
+        }
+        visitedEpoch.resize(blocks.size());
+    }
+
+    struct Result {
+        bool finished;
+        s32 acc;
+    };
+
+    // Runs the program from the start until it ends or a block is about to run a second time
+    Result Run() {
+        if (++epoch == 0) {
+            std::fill(visitedEpoch.begin(), visitedEpoch.end(), 0);
+            epoch = 1;
+        }
+        s32 acc = 0;
+        u32 block = blocks.empty() ? kExit : 0;
+        while (block != kExit) {
+            if (visitedEpoch[block] == epoch) return { false, acc };
+            visitedEpoch[block] = epoch;
+            acc += blocks[block].accDelta;
+            block = blocks[block].next;
+        }
+        return { true, acc };
+    }
+};
+
 void part1(const std::vector<Instruction>& program) {
-    Interpreter interpreter{ program };
-    interpreter.Run();
-    std::cout << "part 1: " << interpreter.acc << "\n";
+    BlockProgram blockProgram{ program };
+    std::cout << "part 1: " << blockProgram.Run().acc << "\n";
+}
+
+// Finds the jmp or nop that, once flipped, lets the program terminate. Returns program.size() if there is none.
+// The reverse control-flow graph is built once and every instruction that leads out of the program is marked by a
+// search backwards from the exits. The program then runs until it reaches a jmp/nop whose flipped successor is
+// marked: none of the instructions before it lead out (the program loops), so the path after the flip can't run
+// into them, and the flip is the repair. Everything is O(n).
+size_t findRepair(const std::vector<Instruction>& program) {
+    const size_t size = program.size();
+    std::vector<u32> predecessorStart(size + 1, 0);
+    for (size_t pc = 0; pc < size; pc++) {
+        size_t next = successor(program[pc], pc);
+        if (next < size) predecessorStart[next + 1]++;
+    }
+    for (size_t pc = 0; pc < size; pc++) {
+        predecessorStart[pc + 1] += predecessorStart[pc];
+    }
+    std::vector<u32> predecessors(predecessorStart[size]);
+    std::vector<u32> insertPos{ predecessorStart.begin(), predecessorStart.end() - 1 };
+    std::vector<u32> toCheck;
+    for (size_t pc = 0; pc < size; pc++) {
+        size_t next = successor(program[pc], pc);
+        if (next < size) {
+            predecessors[insertPos[next]++] = static_cast<u32>(pc);
+        }
+        else {
+            toCheck.push_back(static_cast<u32>(pc));
+        }
+    }
+
+    std::vector<bool> terminates(size);
+    for (u32 pc : toCheck) {
+        terminates[pc] = true;
+    }
+    while (!toCheck.empty()) {
+        u32 pc = toCheck.back();
+        toCheck.pop_back();
+        for (u32 p = predecessorStart[pc]; p < predecessorStart[pc + 1]; p++) {
+            if (!terminates[predecessors[p]]) {
+                terminates[predecessors[p]] = true;
+                toCheck.push_back(predecessors[p]);
+            }
+        }
+    }
+
+    std::vector<bool> visited(size);
+    for (size_t pc = 0; pc < size && !visited[pc]; pc = successor(program[pc], pc)) {
+        visited[pc] = true;
+        if (program[pc].opcode == Instruction::Opcode::Acc) continue;
+        size_t next = successor(flipped(program[pc]), pc);
+        if (next >= size || terminates[next]) return pc;
+    }
+    return size;
 }
 
 void part2(const std::vector<Instruction>& program) {
-    Interpreter interpreter{ program };
-    while (!interpreter.Finished()) {
-        auto instr = interpreter.CurrentInstruction();
-        bool patch = false;
-        switch (instr.opcode) {
-        case Instruction::Opcode::Jmp: patch = true; instr.opcode = Instruction::Opcode::Nop; break;
-        case Instruction::Opcode::Nop: patch = true; instr.opcode = Instruction::Opcode::Jmp; break;
-        case Instruction::Opcode::Acc: break;
-        }
-        if (patch) {
-            Interpreter interpreterCopy{ interpreter };
-            interpreterCopy.ReplaceInstruction(instr);
-            if (interpreterCopy.Run()) {
-                std::cout << "part 2: " << interpreterCopy.acc << "\n";
-                return;
+    size_t repair = findRepair(program);
+    auto repaired = program;
+    if (repair < program.size()) {
+        repaired[repair] = flipped(program[repair]);
+    }
+    BlockProgram blockProgram{ repaired };
+    std::cout << "part 2: " << blockProgram.Run().acc << "\n";
+}
+
+// Per-thread scratch state for PatchedInterpreter. Marks are stamped with the epoch of the run that set them, so
+// starting a run never has to clear them.
+struct RunMarks {
+    std::vector<u32> visitedEpoch;
+    std::vector<u32> patchedEpoch;
+    u32 epoch = 0;
+
+    RunMarks(size_t programSize)
+        : visitedEpoch(programSize), patchedEpoch(programSize) {
+    }
+
+    u32 NextEpoch() {
+        if (++epoch == 0) {
+            std::fill(visitedEpoch.begin(), visitedEpoch.end(), 0);
+            std::fill(patchedEpoch.begin(), patchedEpoch.end(), 0);
+            epoch = 1;
+        }
+        return epoch;
+    }
+};
+
+// Copy-on-write interpreter: the program is shared and never modified, patched instructions live in a small
+// overlay, and visited marks live in the caller's RunMarks. Copying one only copies the overlay and the registers.
+struct PatchedInterpreter {
+    PatchedInterpreter(const std::vector<Instruction>& program)
+        : program(&program) {
+    }
+
+    const std::vector<Instruction>* program;
+    std::vector<std::pair<size_t, Instruction>> patches;
+    s32 acc = 0;
+    size_t pc = 0;
+
+    void Patch(size_t at, const Instruction& instruction) {
+        patches.push_back({ at, instruction });
+    }
+
+    // Runs from the current pc; returns true if the program finished, false when an instruction is about to run a
+    // second time in this call
+    bool Run(RunMarks& marks) {
+        const u32 epoch = marks.NextEpoch();
+        for (auto& [at, instr] : patches) {
+            marks.patchedEpoch[at] = epoch;
+        }
+        auto& code = *program;
+        while (pc < code.size()) {
+            if (marks.visitedEpoch[pc] == epoch) return false;
+            marks.visitedEpoch[pc] = epoch;
+            Instruction instr = code[pc];
+            if (marks.patchedEpoch[pc] == epoch) {
+                for (auto& patch : patches) {
+                    if (patch.first == pc) instr = patch.second;
+                }
+            }
+            switch (instr.opcode) {
+            case Instruction::Opcode::Acc: acc += instr.argument; pc++; break;
+            case Instruction::Opcode::Jmp: pc += instr.argument; break;
+            case Instruction::Opcode::Nop: pc++; break;
+            }
+        }
+        return true;
+    }
+};
+
+struct PatchSearchResult {
+    std::vector<size_t> flips;
+    s32 acc = 0;
+};
+
+// Finds the lexicographically first set of `flipCount` jmp/nop flips that lets the program terminate. Candidate
+// sets are grouped by their first flip and the groups are dealt out to threads round-robin. Each thread explores
+// its groups in order on a snapshot of the shared program, and stops once a terminating set has been found in a
+// group that comes before its own.
+std::optional<PatchSearchResult> findPatches(const std::vector<Instruction>& program, size_t flipCount) {
+    std::vector<size_t> flippable;
+    for (size_t pc = 0; pc < program.size(); pc++) {
+        if (program[pc].opcode != Instruction::Opcode::Acc) flippable.push_back(pc);
+    }
+    if (flipCount == 0 || flipCount > flippable.size()) return std::nullopt;
+
+    const size_t groupCount = flippable.size() - flipCount + 1;
+    std::atomic<size_t> firstFoundGroup{ groupCount };
+    std::vector<std::optional<PatchSearchResult>> groupResults(groupCount);
+    const size_t threadCount = std::min(groupCount, hardwareThreads());
+    runTasks(threadCount, [&](size_t thread) {
+        RunMarks marks{ program.size() };
+        std::vector<size_t> choice(flipCount);
+        for (size_t group = thread; group < groupCount; group += threadCount) {
+            if (group > firstFoundGroup.load()) return;
+            // choice holds indices into flippable in increasing order; advance it like an odometer
+            choice[0] = group;
+            for (size_t i = 1; i < flipCount; i++) {
+                choice[i] = group + i;
+            }
+            for (;;) {
+                if (group > firstFoundGroup.load()) return;
+                PatchedInterpreter interpreter{ program };
+                for (size_t index : choice) {
+                    interpreter.Patch(flippable[index], flipped(program[flippable[index]]));
+                }
+                if (interpreter.Run(marks)) {
+                    auto& result = groupResults[group].emplace();
+                    for (size_t index : choice) {
+                        result.flips.push_back(flippable[index]);
+                    }
+                    result.acc = interpreter.acc;
+                    size_t current = firstFoundGroup.load();
+                    while (group < current && !firstFoundGroup.compare_exchange_weak(current, group)) {}
+                    return;
+                }
+                size_t i = flipCount;
+                while (i > 1 && choice[i - 1] == flippable.size() - (flipCount - i + 1)) {
+                    i--;
+                }
+                if (i == 1) break;
+                choice[i - 1]++;
+                for (size_t j = i; j < flipCount; j++) {
+                    choice[j] = choice[j - 1] + 1;
+                }
             }
         }
-        interpreter.RunOnce();
+    });
+
+    size_t found = firstFoundGroup.load();
+    return (found < groupCount) ? groupResults[found] : std::nullopt;
+}
+
+// Runs the program under ExecutionProfiler and prints the detected loop and a tab-separated table with one row per
+// instruction, ordered by the given column (pc, count or jumps; counts are sorted in descending order)
+void profile(const std::vector<Instruction>& program, std::string_view sortColumn) {
+    Interpreter<ExecutionProfiler> interpreter{ program };
+    bool finished = interpreter.Run();
+    auto& profiler = interpreter.profiler;
+    if (finished) {
+        std::cout << "finished after " << profiler.steps << " steps, acc " << interpreter.acc << "\n";
+    }
+    else {
+        std::cout << "loop at pc " << profiler.loop->entry << ": " << profiler.loop->length << " instructions, acc "
+            << (profiler.loop->accDelta >= 0 ? "+" : "") << profiler.loop->accDelta << " per iteration\n";
+    }
+
+    std::vector<size_t> rows(program.size());
+    for (size_t pc = 0; pc < rows.size(); pc++) {
+        rows[pc] = pc;
+    }
+    auto sortBy = [&](const std::vector<u64>& column) {
+        std::stable_sort(rows.begin(), rows.end(), [&](size_t a, size_t b) { return column[a] > column[b]; });
+    };
+    if (sortColumn == "count") {
+        sortBy(profiler.counts);
+    }
+    else if (sortColumn == "jumps") {
+        sortBy(profiler.jumps);
+    }
+
+    constexpr std::string_view opcodeNames[] = { "acc", "jmp", "nop" };
+    std::cout << "pc\top\targ\tcount\tjumps\tloop\n";
+    for (size_t pc : rows) {
+        auto& instr = program[pc];
+        std::cout << pc << "\t" << opcodeNames[static_cast<size_t>(instr.opcode)] << "\t" << instr.argument << "\t"
+            << profiler.counts[pc] << "\t" << profiler.jumps[pc] << "\t" << profiler.InLoop(pc) << "\n";
     }
-    std::cout << "part 2: " << interpreter.acc << "\n";
 }
 
 auto loadInput() {
@@ -131,8 +496,30 @@ auto loadInput() {
     return program;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     auto program = loadInput();
+
+    // day08 --profile [pc|count|jumps]
+    if (argc >= 2 && std::string_view{ argv[1] } == "--profile") {
+        profile(program, (argc >= 3) ? argv[2] : "pc");
+        return 0;
+    }
+
+    // day08 --flips <k>
+    if (argc >= 3 && std::string_view{ argv[1] } == "--flips") {
+        auto result = findPatches(program, std::stoul(argv[2]));
+        if (!result) {
+            std::cout << "no terminating patch\n";
+            return 0;
+        }
+        std::cout << "flips:";
+        for (size_t pc : result->flips) {
+            std::cout << " " << pc;
+        }
+        std::cout << "\nacc: " << result->acc << "\n";
+        return 0;
+    }
+
     part1(program);
     part2(program);
     return 0;
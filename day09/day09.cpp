@@ -1,4 +1,5 @@
 #include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <unordered_map>
@@ -6,12 +7,22 @@
 
 using u64 = uint64_t;
 
-template <typename Func>
-void process(const std::vector<u64>& nums, Func&& func) {
+// Invokes func with the first number that is not the sum of two distinct numbers among the previous preambleSize
+// numbers. The preamble size is a template parameter so the usual size gets fully unrolled inner loops;
+// preambleSize == 0 reads the size from the runtime argument instead. The preamble needs at least two numbers to
+// form a sum.
+template <size_t preambleSize, typename Func>
+void process(const std::vector<u64>& nums, Func&& func, size_t runtimePreambleSize = preambleSize) {
+    static_assert(preambleSize == 0 || preambleSize >= 2, "preamble must hold at least two numbers");
+    const size_t preamble = (preambleSize != 0) ? preambleSize : runtimePreambleSize;
+    if (preamble < 2) {
+        std::abort();
+    }
+
     // process preamble
     std::unordered_map<u64, u64> counts;
-    for (size_t i = 0; i < 24; i++) {
-        for (size_t j = i + 1; j < 25; j++) {
+    for (size_t i = 0; i < preamble - 1; i++) {
+        for (size_t j = i + 1; j < preamble; j++) {
             if (nums[i] != nums[j]) {
                 counts[nums[i] + nums[j]]++;
             }
@@ -19,20 +30,30 @@ void process(const std::vector<u64>& nums, Func&& func) {
     }
 
     // process remainder
-    for (size_t i = 25; i < nums.size(); i++) {
+    for (size_t i = preamble; i < nums.size(); i++) {
         if (counts[nums[i]] == 0) {
             func(nums[i]);
             break;
         }
-        for (size_t j = i - 24; j < i; j++) {
+        for (size_t j = i - (preamble - 1); j < i; j++) {
             if (nums[i] != nums[j]) {
                 counts[nums[i] + nums[j]]++;
             }
-            counts[nums[i - 25] + nums[j]]--;
+            counts[nums[i - preamble] + nums[j]]--;
         }
     }
 }
 
+template <typename Func>
+void process(const std::vector<u64>& nums, size_t preambleSize, Func&& func) {
+    if (preambleSize == 25) {
+        process<25>(nums, func);
+    }
+    else {
+        process<0>(nums, func, preambleSize);
+    }
+}
+
 void findContiguous(const std::vector<u64>& num, u64 target) {
     auto start = num.begin();
     auto end = num.begin();
@@ -60,13 +81,13 @@ void findContiguous(const std::vector<u64>& num, u64 target) {
 }
 
 void part1(const std::vector<u64>& nums) {
-    process(nums, [](u64 num) {
+    process(nums, 25, [](u64 num) {
         std::cout << "part 1: " << num << "\n";
     });
 }
 
 void part2(const std::vector<u64>& nums) {
-    process(nums, [&](u64 num) {
+    process(nums, 25, [&](u64 num) {
         findContiguous(nums, num);
     });
 }
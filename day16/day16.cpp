@@ -1,11 +1,15 @@
 #include <fstream>
 #include <iostream>
-#include <sstream>
 #include <regex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <cstdint>
+#include <charconv>
+#include <cstdlib>
+#include <string_view>
+
+#include "../common/records.h"
 
 using u32 = uint32_t;
 using u64 = uint64_t;
@@ -129,53 +133,49 @@ void part2(const DataSet& dataSet) {
 
 DataSet loadInput() {
     DataSet dataSet;
-    std::fstream f{ "input.txt" };
+    auto file = loadRecords("input.txt");
     std::regex rgxRule{ "(.+): (\\d+)-(\\d+) or (\\d+)-(\\d+)" };
 
-    std::string line;
+    // The input has three blank-line-separated sections: rules, "your ticket:" and "nearby tickets:"
+    if (file.recordCount() != 3) {
+        std::abort();
+    }
+
     // Each line has a rule in the format:
     // <name>: <range> or <range>
-    // The list ends with a blank line.
-    while (std::getline(f, line)) {
-        if (line.empty()) break;
-
-        std::smatch match;
-        if (std::regex_match(line, match, rgxRule)) {
+    for (auto line : file.record(0)) {
+        std::cmatch match;
+        if (std::regex_match(line.data(), line.data() + line.size(), match, rgxRule)) {
             auto name = match[1].str();
-            Range range1{ std::stoul(match[2].str()), std::stoul(match[3].str()) };
-            Range range2{ std::stoul(match[4].str()), std::stoul(match[5].str()) };
+            Range range1{ (u32)std::stoul(match[2].str()), (u32)std::stoul(match[3].str()) };
+            Range range2{ (u32)std::stoul(match[4].str()), (u32)std::stoul(match[5].str()) };
             dataSet.rules.emplace(std::make_pair(name, std::make_pair(range1, range2)));
         }
     }
 
-    auto parseTicket = [](const std::string& line) -> Ticket {
+    auto parseTicket = [](std::string_view line) -> Ticket {
         Ticket ticket;
-        std::istringstream ss{ line };
-        std::string number;
-        while (std::getline(ss, number, ',')) {
-            ticket.push_back(std::stoul(number));
-        }
+        forEachField(line, ',', [&](std::string_view number) {
+            u32 value = 0;
+            std::from_chars(number.data(), number.data() + number.size(), value);
+            ticket.push_back(value);
+        });
         return ticket;
     };
 
-    // Next line should be "your ticket:", followed by a list of numbers that represent a ticket,
-    // followed by a blank line
-    std::getline(f, line);
-    if (line != "your ticket:") {
+    // "your ticket:" followed by a list of numbers that represent a ticket
+    auto myTicketSection = file.record(1);
+    if (myTicketSection.size() != 2 || myTicketSection[0] != "your ticket:") {
         std::abort();
     }
-    std::getline(f, line);
-    dataSet.myTicket = parseTicket(line);
-    std::getline(f, line);
-
-    // Next line should be "nearby tickets:", followed by multiple lines representing nearby tickets.
-    // The list ends with a blank line.
-    std::getline(f, line);
-    if (line != "nearby tickets:") {
+    dataSet.myTicket = parseTicket(myTicketSection[1]);
+
+    // "nearby tickets:" followed by multiple lines representing nearby tickets
+    auto nearbyTicketsSection = file.record(2);
+    if (nearbyTicketsSection.empty() || nearbyTicketsSection[0] != "nearby tickets:") {
         std::abort();
     }
-    while (std::getline(f, line)) {
-        if (line.empty()) break;
+    for (auto line : nearbyTicketsSection.subspan(1)) {
         dataSet.nearbyTickets.push_back(parseTicket(line));
     }
 
@@ -52,63 +52,17 @@ struct PocketDimension {
         }
     }
 
-    void simulate3D() {
-        constexpr auto neighbors = []() -> auto {
-            std::array<Coord, 3 * 3 * 3 - 1> coords;
+    // Runs one simulation step in 3 or 4 dimensions. Dimensions past the first `dims` stay fixed at 0, and the
+    // neighbor table is sized and built at compile time for the chosen dimension count.
+    template <size_t dims>
+    void simulate() {
+        static_assert(dims == 3 || dims == 4, "only 3D and 4D pocket dimensions are supported");
+
+        static constexpr s32 wRange = (dims >= 4) ? 1 : 0;
+        static constexpr auto neighbors = []() -> auto {
+            std::array<Coord, 3 * 3 * 3 * (wRange * 2 + 1) - 1> coords;
             size_t i = 0;
-            for (s32 z = -1; z <= +1; z++) {
-                for (s32 y = -1; y <= +1; y++) {
-                    for (s32 x = -1; x <= +1; x++) {
-                        if (x == 0 && y == 0 && z == 0) continue;
-                        coords[i++] = { x, y, z, 0 };
-                    }
-                }
-            }
-            return coords;
-        }();
-
-        Coord newMinCoord{ 0, 0, 0, 0 };
-        Coord newMaxCoord{ 0, 0, 0, 0 };
-
-        std::unordered_set<Coord> newState;
-
-        for (s32 z = minCoord.z - 1; z <= maxCoord.z + 1; z++) {
-            for (s32 y = minCoord.y - 1; y <= maxCoord.y + 1; y++) {
-                for (s32 x = minCoord.x - 1; x <= maxCoord.x + 1; x++) {
-                    Coord coord{ x, y, z, 0 };
-                    u32 neighborCount = 0;
-                    for (auto& neighbor : neighbors) {
-                        if (activeCells.contains(coord + neighbor)) {
-                            neighborCount++;
-                        }
-                    }
-                    bool currActive = activeCells.contains(coord);
-                    if ((currActive && (neighborCount == 2 || neighborCount == 3))
-                        || (!currActive && neighborCount == 3)) {
-
-                        newState.insert(coord);
-
-                        newMinCoord.x = std::min(x, newMinCoord.x);
-                        newMinCoord.y = std::min(y, newMinCoord.y);
-                        newMinCoord.z = std::min(z, newMinCoord.z);
-
-                        newMaxCoord.x = std::max(x, newMaxCoord.x);
-                        newMaxCoord.y = std::max(y, newMaxCoord.y);
-                        newMaxCoord.z = std::max(z, newMaxCoord.z);
-                    }
-                }
-            }
-        }
-        activeCells = newState;
-        minCoord = newMinCoord;
-        maxCoord = newMaxCoord;
-    }
-
-    void simulate4D() {
-        constexpr auto neighbors = []() -> auto {
-            std::array<Coord, 3 * 3 * 3 * 3 - 1> coords;
-            size_t i = 0;
-            for (s32 w = -1; w <= +1; w++) {
+            for (s32 w = -wRange; w <= +wRange; w++) {
                 for (s32 z = -1; z <= +1; z++) {
                     for (s32 y = -1; y <= +1; y++) {
                         for (s32 x = -1; x <= +1; x++) {
@@ -126,7 +80,7 @@ struct PocketDimension {
 
         std::unordered_set<Coord> newState;
 
-        for (s32 w = minCoord.w - 1; w <= maxCoord.w + 1; w++) {
+        for (s32 w = minCoord.w - wRange; w <= maxCoord.w + wRange; w++) {
             for (s32 z = minCoord.z - 1; z <= maxCoord.z + 1; z++) {
                 for (s32 y = minCoord.y - 1; y <= maxCoord.y + 1; y++) {
                     for (s32 x = minCoord.x - 1; x <= maxCoord.x + 1; x++) {
@@ -151,7 +105,7 @@ struct PocketDimension {
                             newMaxCoord.x = std::max(x, newMaxCoord.x);
                             newMaxCoord.y = std::max(y, newMaxCoord.y);
                             newMaxCoord.z = std::max(z, newMaxCoord.z);
-                            newMaxCoord.w = std::max(z, newMaxCoord.w);
+                            newMaxCoord.w = std::max(w, newMaxCoord.w);
                         }
                     }
                 }
@@ -162,15 +116,10 @@ struct PocketDimension {
         maxCoord = newMaxCoord;
     }
 
-    void simulate3D(u32 iterations) {
-        for (u32 i = 0; i < iterations; i++) {
-            simulate3D();
-        }
-    }
-
-    void simulate4D(u32 iterations) {
+    template <size_t dims>
+    void simulate(u32 iterations) {
         for (u32 i = 0; i < iterations; i++) {
-            simulate4D();
+            simulate<dims>();
         }
     }
 
@@ -185,13 +134,13 @@ struct PocketDimension {
 
 void part1(const std::vector<std::string>& initialState) {
     PocketDimension dimension{ initialState };
-    dimension.simulate3D(6);
+    dimension.simulate<3>(6);
     std::cout << "part 1: " << dimension.cellCount() << '\n';
 }
 
 void part2(const std::vector<std::string>& initialState) {
     PocketDimension dimension{ initialState };
-    dimension.simulate4D(6);
+    dimension.simulate<4>(6);
     std::cout << "part 2: " << dimension.cellCount() << '\n';
 }
 
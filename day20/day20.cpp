@@ -8,15 +8,24 @@
 #include <cstdint>
 #include <algorithm>
 #include <bit>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+
+#include "../common/records.h"
 
 using u16 = uint16_t;
 using u32 = uint32_t;
 using u64 = uint64_t;
 
+// One bit per cell along a tile edge, so tiles can be up to 64 cells wide
+using EdgeBits = u64;
+
 struct Tile {
     u32 id;
     std::vector<std::string> map;
-    u16 edgeBits[4];
+    EdgeBits edgeBits[4];
 
     void rotateCW() {
         // Rotate in place with a 4-way swap
@@ -46,7 +55,7 @@ struct Tile {
         std::reverse(map.begin(), map.end());
     }
 
-    void matchTop(u16 bits) {
+    void matchTop(EdgeBits bits) {
         for (size_t v = 0; v < 2; v++) {
             for (size_t h = 0; h < 2; h++) {
                 for (size_t r = 0; r < 4; r++) {
@@ -60,7 +69,7 @@ struct Tile {
         }
     }
 
-    void matchLeft(u16 bits) {
+    void matchLeft(EdgeBits bits) {
         for (size_t v = 0; v < 2; v++) {
             for (size_t h = 0; h < 2; h++) {
                 for (size_t r = 0; r < 4; r++) {
@@ -74,34 +83,34 @@ struct Tile {
         }
     }
 
-    u16 topBits() const {
-        u16 bits = 0;
+    EdgeBits topBits() const {
+        EdgeBits bits = 0;
         for (size_t i = 0; i < map.size(); i++) {
-            if (map[0][i] == '#') bits |= (1 << i);
+            if (map[0][i] == '#') bits |= EdgeBits{ 1 } << i;
         }
         return bits;
     }
 
-    u16 lftBits() const {
-        u16 bits = 0;
+    EdgeBits lftBits() const {
+        EdgeBits bits = 0;
         for (size_t i = 0; i < map.size(); i++) {
-            if (map[i][0] == '#') bits |= (1 << i);
+            if (map[i][0] == '#') bits |= EdgeBits{ 1 } << i;
         }
         return bits;
     }
 
-    u16 btmBits() const {
-        u16 bits = 0;
+    EdgeBits btmBits() const {
+        EdgeBits bits = 0;
         for (size_t i = 0; i < map.size(); i++) {
-            if (map[map.size() - 1][i] == '#') bits |= (1 << i);
+            if (map[map.size() - 1][i] == '#') bits |= EdgeBits{ 1 } << i;
         }
         return bits;
     }
 
-    u16 rgtBits() const {
-        u16 bits = 0;
+    EdgeBits rgtBits() const {
+        EdgeBits bits = 0;
         for (size_t i = 0; i < map.size(); i++) {
-            if (map[i][map.size() - 1] == '#') bits |= (1 << i);
+            if (map[i][map.size() - 1] == '#') bits |= EdgeBits{ 1 } << i;
         }
         return bits;
     }
@@ -114,36 +123,54 @@ struct Tile {
     }
 };
 
-u16 bitReverse10(u16 bits) {
-    u16 result = ((bits & 0b11111'00000) >> 5) | ((bits & 0b00000'11111) << 5);
-    return ((result & 0b10000'10000) >> 4) | ((result & 0b01000'01000) >> 2)
-        | ((result & 0b00100'00100))
-        | ((result & 0b00010'00010) << 2) | ((result & 0b00001'00001) << 4);
+// Square 2D array with compile-time dimensions when N > 0, or sized at runtime when N == 0
+template <typename T, size_t N>
+struct SquareGrid {
+    using type = std::array<std::array<T, N>, N>;
+    static type make(size_t) { return {}; }
+};
+
+template <typename T>
+struct SquareGrid<T, 0> {
+    using type = std::vector<std::vector<T>>;
+    static type make(size_t size) { return type(size, std::vector<T>(size)); }
+};
+
+// Reverses the low `width` bits of an edge
+EdgeBits bitReverse(EdgeBits bits, size_t width) {
+    assert(width >= 1 && width <= 64);
+    bits = ((bits >> 1) & 0x5555'5555'5555'5555) | ((bits & 0x5555'5555'5555'5555) << 1);
+    bits = ((bits >> 2) & 0x3333'3333'3333'3333) | ((bits & 0x3333'3333'3333'3333) << 2);
+    bits = ((bits >> 4) & 0x0F0F'0F0F'0F0F'0F0F) | ((bits & 0x0F0F'0F0F'0F0F'0F0F) << 4);
+    bits = ((bits >> 8) & 0x00FF'00FF'00FF'00FF) | ((bits & 0x00FF'00FF'00FF'00FF) << 8);
+    bits = ((bits >> 16) & 0x0000'FFFF'0000'FFFF) | ((bits & 0x0000'FFFF'0000'FFFF) << 16);
+    bits = (bits >> 32) | (bits << 32);
+    return bits >> (64 - width);
 }
 
 void part1(std::vector<Tile>& tiles) {
     // Build lookup tables for edge bits -> count
-    std::unordered_map<u16, u32> edgeCounts;
+    std::unordered_map<EdgeBits, u32> edgeCounts;
     for (auto& tile : tiles) {
         for (auto& bits : tile.edgeBits) {
             edgeCounts[bits]++;
-            edgeCounts[bitReverse10(bits)]++;
+            edgeCounts[bitReverse(bits, tile.map.size())]++;
         }
     }
 
     u64 total = 1;
     for (auto& tile : tiles) {
         // Find non-shared edges
-        std::unordered_set<u16> uniqueEdges;
+        std::unordered_set<EdgeBits> uniqueEdges;
         u16 uniqueEdgeMask = 0;
         for (size_t i = 0; i < 4; i++) {
             auto edgeBits = tile.edgeBits[i];
             auto edgeCount = edgeCounts[edgeBits];
-            auto revEdgeCount = edgeCounts[bitReverse10(edgeBits)];
+            auto revEdgeCount = edgeCounts[bitReverse(edgeBits, tile.map.size())];
             if (edgeCount == 1 && revEdgeCount == 1) {
                 uniqueEdgeMask |= (1 << i);
                 uniqueEdges.insert(edgeBits);
-                uniqueEdges.insert(bitReverse10(edgeBits));
+                uniqueEdges.insert(bitReverse(edgeBits, tile.map.size()));
             }
         }
 
@@ -156,16 +183,25 @@ void part1(std::vector<Tile>& tiles) {
     std::cout << "part 1: " << total << '\n';
 }
 
+// gridSize is the number of tiles per side of the stitched image and tileSize is the width of each tile including
+// its border. Passing 0 for both sizes the stitched grid and image at runtime.
+template <size_t gridSize, size_t tileSize>
 void part2(std::vector<Tile>& tiles) {
+    static_assert((gridSize == 0) == (tileSize == 0), "grid and tile sizes must both be fixed or both be dynamic");
+    static constexpr size_t imageSize = gridSize * (tileSize - 2);
+    const size_t numTilesPerSide = (gridSize != 0) ? gridSize : std::lround(std::sqrt(tiles.size()));
+    const size_t tileInnerSize = (tileSize != 0) ? tileSize - 2 : tiles[0].map.size() - 2;
+    const size_t fullImageSize = numTilesPerSide * tileInnerSize;
+
     // Build lookup tables for edge bits -> count and edge bits -> tiles
-    std::unordered_map<u16, u32> edgeCounts;
-    std::unordered_multimap<u16, Tile*> tileLookup;
+    std::unordered_map<EdgeBits, u32> edgeCounts;
+    std::unordered_multimap<EdgeBits, Tile*> tileLookup;
     for (auto& tile : tiles) {
         for (auto& bits : tile.edgeBits) {
             edgeCounts[bits]++;
-            edgeCounts[bitReverse10(bits)]++;
+            edgeCounts[bitReverse(bits, tile.map.size())]++;
             tileLookup.insert({ bits, &tile });
-            tileLookup.insert({ bitReverse10(bits), &tile });
+            tileLookup.insert({ bitReverse(bits, tile.map.size()), &tile });
         }
     }
 
@@ -173,16 +209,16 @@ void part2(std::vector<Tile>& tiles) {
     Tile* cornerTile = nullptr;
     for (auto& tile : tiles) {
         // Find non-shared edges
-        std::unordered_set<u16> uniqueEdges;
+        std::unordered_set<EdgeBits> uniqueEdges;
         u16 uniqueEdgeMask = 0;
         for (size_t i = 0; i < 4; i++) {
             auto edgeBits = tile.edgeBits[i];
             auto edgeCount = edgeCounts[edgeBits];
-            auto revEdgeCount = edgeCounts[bitReverse10(edgeBits)];
+            auto revEdgeCount = edgeCounts[bitReverse(edgeBits, tile.map.size())];
             if (edgeCount == 1 && revEdgeCount == 1) {
                 uniqueEdgeMask |= (1 << i);
                 uniqueEdges.insert(edgeBits);
-                uniqueEdges.insert(bitReverse10(edgeBits));
+                uniqueEdges.insert(bitReverse(edgeBits, tile.map.size()));
             }
         }
 
@@ -194,14 +230,14 @@ void part2(std::vector<Tile>& tiles) {
     }
 
     // Stitch image
-    std::array<std::array<const Tile*, 12>, 12> stitchedImage;
-    for (size_t y = 0; y < 12; y++) {
-        for (size_t x = 0; x < 12; x++) {
+    auto stitchedImage = SquareGrid<const Tile*, gridSize>::make(numTilesPerSide);
+    for (size_t y = 0; y < numTilesPerSide; y++) {
+        for (size_t x = 0; x < numTilesPerSide; x++) {
             if (x == 0 && y == 0) {
                 // Top-left corner
                 // Rotate/flip the corner tile to place the unique edges at the top and left
                 for (size_t i = 0; i < 8; i++) {
-                    if (edgeCounts[cornerTile->topBits()] == 1 && edgeCounts[cornerTile->lftBits()]) {
+                    if (edgeCounts[cornerTile->topBits()] == 1 && edgeCounts[cornerTile->lftBits()] == 1) {
                         // Found the correct orientation
                         break;
                     }
@@ -247,15 +283,15 @@ void part2(std::vector<Tile>& tiles) {
     }
 
     // Construct full image, discarding edges, and count number of marked cells
-    std::array<std::array<bool, 96>, 96> image;
+    auto image = SquareGrid<bool, imageSize>::make(fullImageSize);
     u32 cellCount = 0;
-    for (size_t ty = 0; ty < 12; ty++) {
-        for (size_t tx = 0; tx < 12; tx++) {
+    for (size_t ty = 0; ty < numTilesPerSide; ty++) {
+        for (size_t tx = 0; tx < numTilesPerSide; tx++) {
             auto& tile = *stitchedImage[ty][tx];
-            for (size_t y = 0; y < 8; y++) {
-                for (size_t x = 0; x < 8; x++) {
+            for (size_t y = 0; y < tileInnerSize; y++) {
+                for (size_t x = 0; x < tileInnerSize; x++) {
                     bool filled = (tile.map[y + 1][x + 1] == '#');
-                    image[ty * 8 + y][tx * 8 + x] = filled;
+                    image[ty * tileInnerSize + y][tx * tileInnerSize + x] = filled;
                     if (filled) {
                         cellCount++;
                     }
@@ -279,8 +315,8 @@ void part2(std::vector<Tile>& tiles) {
     for (size_t h = 0; h < 2; h++) {
         for (size_t r = 0; r < 4; r++) {
             // Scan map for the sea monster
-            for (size_t y = 0; y < 96 - monsterHeight; y++) {
-                for (size_t x = 0; x < 96 - monsterWidth; x++) {
+            for (size_t y = 0; y < fullImageSize - monsterHeight; y++) {
+                for (size_t x = 0; x < fullImageSize - monsterWidth; x++) {
                     u32 count = 0;
                     for (size_t my = 0; my < monsterHeight; my++) {
                         for (size_t mx = 0; mx < monsterWidth; mx++) {
@@ -304,7 +340,7 @@ void part2(std::vector<Tile>& tiles) {
                 for (size_t x = y; x < sz - 1 - y; x++) {
                     auto fx = x;
                     auto rx = sz - 1 - x;
-                    auto tmp = image[fy][fx];
+                    bool tmp = image[fy][fx];
                     image[fy][fx] = image[rx][fy];
                     image[rx][fy] = image[ry][rx];
                     image[ry][rx] = image[fx][ry];
@@ -324,21 +360,23 @@ void part2(std::vector<Tile>& tiles) {
 
 std::vector<Tile> loadInput() {
     std::vector<Tile> tiles;
-    std::fstream f{ "input.txt" };
-    std::string line;
-    Tile tile;
-    while (std::getline(f, line)) {
-        if (line.empty()) {
-            tile.calcEdgeBits();
-            tiles.push_back(tile);
-            tile.map.clear();
-        }
-        else if (line.starts_with("Tile")) {
-            tile.id = std::stoul(line.substr(5, line.find(':') - 5));
+    auto file = loadRecords("input.txt");
+    tiles.reserve(file.recordCount());
+    for (size_t i = 0; i < file.recordCount(); i++) {
+        // Each tile is a "Tile <id>:" header followed by its map
+        auto lines = file.record(i);
+        Tile tile;
+        auto header = lines[0];
+        std::from_chars(header.data() + 5, header.data() + header.size(), tile.id);
+        for (auto line : lines.subspan(1)) {
+            tile.map.emplace_back(line);
         }
-        else {
-            tile.map.push_back(line);
+        if (tile.map.empty() || tile.map.size() > 64) {
+            // No edges, or edges wider than EdgeBits
+            std::abort();
         }
+        tile.calcEdgeBits();
+        tiles.push_back(std::move(tile));
     }
     return tiles;
 }
@@ -346,6 +384,11 @@ std::vector<Tile> loadInput() {
 int main() {
     auto tiles = loadInput();
     part1(tiles);
-    part2(tiles);
+    if (tiles.size() == 144 && tiles[0].map.size() == 10) {
+        part2<12, 10>(tiles);
+    }
+    else {
+        part2<0, 0>(tiles);
+    }
     return 0;
 }
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <set>
@@ -9,6 +10,8 @@
 #include <unordered_set>
 #include <cstdint>
 
+#include "../common/records.h"
+
 using u64 = uint64_t;
 
 struct Food {
@@ -116,23 +119,24 @@ void part2(const FoodCollection& foods) {
 
 auto loadInput() {
     FoodCollection foods;
-    std::ifstream f{ "input.txt" };
-    std::string line;
-    while (std::getline(f, line)) {
-        auto splitPos = line.find(" (contains");
-        std::istringstream ingredients{ line.substr(0, splitPos) };
-        std::istringstream allergens{ line.substr(splitPos + 11, line.size() - splitPos - 12) };
+    auto file = loadRecords("input.txt");
+    for (auto line : file.lines) {
+        // <ingredient> <ingredient> ... (contains <allergen>, <allergen>, ...)
+        constexpr std::string_view containsPrefix = " (contains ";
+        auto splitPos = line.find(containsPrefix);
+        auto ingredients = line.substr(0, splitPos);
+        auto allergens = line.substr(splitPos + containsPrefix.size());
+        allergens.remove_suffix(1); // ')'
 
         Food food;
-        std::string value;
-        while (ingredients >> value) {
-            food.ingredients.insert(value);
-        }
-        while (std::getline(allergens, value, ',')) {
-            if (value[0] == ' ') value = value.substr(1);
-            food.allergens.insert(value);
-        }
-        foods.foods.push_back(food);
+        forEachField(ingredients, ' ', [&](std::string_view value) {
+            food.ingredients.emplace(value);
+        });
+        forEachField(allergens, ',', [&](std::string_view value) {
+            if (value[0] == ' ') value.remove_prefix(1);
+            food.allergens.emplace(value);
+        });
+        foods.foods.push_back(std::move(food));
     }
     foods.computeAllergens();
     return foods;
@@ -7,6 +7,9 @@
 #include <vector>
 #include <cstdint>
 #include <unordered_set>
+#include <charconv>
+
+#include "../common/records.h"
 
 using u32 = uint32_t;
 using u64 = uint64_t;
@@ -147,19 +150,14 @@ void part2(const Game& game) {
 
 Game loadInput() {
     Game game;
-    std::ifstream f{ "input.txt" };
-    std::string line;
-    std::vector<u32>* hand = &game.playerHands[0];
-    std::getline(f, line); // skip "Player 1"
-    while (std::getline(f, line)) {
-        if (line.empty()) {
-            continue;
-        }
-        else if (line.starts_with("Player 2")) {
-            hand = &game.playerHands[1];
-        }
-        else {
-            hand->push_back(std::stoul(line));
+    auto file = loadRecords("input.txt");
+    // One record per player: a "Player N:" header followed by one card per line
+    for (size_t i = 0; i < file.recordCount() && i < game.playerHands.size(); i++) {
+        auto& hand = game.playerHands[i];
+        for (auto line : file.record(i).subspan(1)) {
+            u32 card = 0;
+            std::from_chars(line.data(), line.data() + line.size(), card);
+            hand.push_back(card);
         }
     }
     return game;
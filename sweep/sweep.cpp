@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using u32 = uint32_t;
+using u64 = uint64_t;
+
+// Size sweep over the days with generated inputs. For each day, an input of every size is written to
+// sweep_work/<day>/input.txt and the day's executable is run on it with AOC_THREADS set to each thread count.
+// Results go to stdout as CSV; exponent is the least-squares slope of log(time) against log(size) over all sizes
+// of that day and thread count, so 1 is linear and 2 is quadratic. Times include process startup, which dominates
+// the smallest sizes and pulls the exponent down.
+
+// Writes an input of the given size (lines, records, rules or nesting depth, depending on the day)
+using Generator = std::function<void(std::ofstream&, size_t, std::mt19937_64&)>;
+
+struct Day {
+    const char* name;
+    Generator generate;
+    std::vector<size_t> sizes;
+};
+
+// Expense report: one number per line
+void generateDay01(std::ofstream& f, size_t size, std::mt19937_64& rng) {
+    for (size_t i = 0; i < size; i++) {
+        f << (rng() % 2020) << "\n";
+    }
+}
+
+// Password policies: "<min>-<max> <ch>: <password>"
+void generateDay02(std::ofstream& f, size_t size, std::mt19937_64& rng) {
+    for (size_t i = 0; i < size; i++) {
+        u32 min = rng() % 5 + 1;
+        u32 max = min + rng() % 10;
+        char ch = static_cast<char>('a' + rng() % 26);
+        f << min << "-" << max << " " << ch << ": ";
+        size_t length = rng() % 16 + 4;
+        for (size_t c = 0; c < length; c++) {
+            f << static_cast<char>('a' + rng() % 26);
+        }
+        f << "\n";
+    }
+}
+
+// Tree map: rows of the puzzle's width with a tree on roughly one square in five
+void generateDay03(std::ofstream& f, size_t size, std::mt19937_64& rng) {
+    for (size_t i = 0; i < size; i++) {
+        for (size_t x = 0; x < 31; x++) {
+            f << ((rng() % 5 == 0) ? '#' : '.');
+        }
+        f << "\n";
+    }
+}
+
+// Passports: one record per size, with random fields and blank lines between records
+void generateDay04(std::ofstream& f, size_t size, std::mt19937_64& rng) {
+    const char* fields[] = { "byr:1980", "iyr:2015", "eyr:2025", "hgt:180cm", "hcl:#123abc", "ecl:brn",
+        "pid:000000001", "cid:100" };
+    for (size_t i = 0; i < size; i++) {
+        for (size_t field = 0; field < 8; field++) {
+            if (rng() % 8 == 0) continue;
+            f << fields[field] << ((field % 3 == 2) ? "\n" : " ");
+        }
+        f << "\n\n";
+    }
+}
+
+// Boarding passes: codes long enough for size seats, taking every seat of a range but one, in random order
+void generateDay05(std::ofstream& f, size_t size, std::mt19937_64& rng) {
+    size_t codeLength = 10;
+    while ((u64{ 1 } << codeLength) < 2 * size) {
+        codeLength++;
+    }
+    std::vector<u64> ids(size);
+    u64 first = rng() % size;
+    u64 missing = first + 1 + rng() % (size - 1);
+    for (size_t i = 0; i < size; i++) {
+        ids[i] = first + i + (first + i >= missing);
+    }
+    std::shuffle(ids.begin(), ids.end(), rng);
+    std::string code(codeLength, ' ');
+    for (u64 id : ids) {
+        for (size_t c = 0; c < codeLength; c++) {
+            bool set = (id >> (codeLength - 1 - c)) & 1;
+            code[c] = (c + 3 < codeLength) ? (set ? 'B' : 'F') : (set ? 'R' : 'L');
+        }
+        f << code << "\n";
+    }
+}
+
+// Customs answers: groups of 1 to 5 people
+void generateDay06(std::ofstream& f, size_t size, std::mt19937_64& rng) {
+    for (size_t i = 0; i < size; i++) {
+        size_t people = rng() % 5 + 1;
+        for (size_t p = 0; p < people; p++) {
+            u32 answers = static_cast<u32>(rng()) & ((1u << 26) - 1);
+            for (u32 q = 0; q < 26; q++) {
+                if (answers & (1u << q)) f << static_cast<char>('a' + q);
+            }
+            f << "\n";
+        }
+        f << "\n";
+    }
+}
+
+// Bag rules: color i holds up to 3 colors with higher numbers, so the graph is a DAG; shiny gold sits in the middle
+void generateDay07(std::ofstream& f, size_t size, std::mt19937_64& rng) {
+    auto color = [&](size_t i) {
+        return (i == size / 2) ? std::string{ "shiny gold" } : "shade" + std::to_string(i) + " hue";
+    };
+    for (size_t i = 0; i < size; i++) {
+        f << color(i) << " bags contain ";
+        size_t contained = (i + 1 < size) ? rng() % 4 : 0;
+        if (contained == 0) {
+            f << "no other bags.\n";
+            continue;
+        }
+        for (size_t c = 0; c < contained; c++) {
+            size_t inner = i + 1 + rng() % std::min<size_t>(size - i - 1, 64);
+            u32 count = static_cast<u32>(rng() % 4 + 1);
+            f << (c > 0 ? ", " : "") << count << " " << color(inner) << (count == 1 ? " bag" : " bags");
+        }
+        f << ".\n";
+    }
+}
+
+// Handheld program: forward jumps and accumulator updates, ending in a jump back to the start
+void generateDay08(std::ofstream& f, size_t size, std::mt19937_64& rng) {
+    for (size_t i = 0; i + 1 < size; i++) {
+        switch (rng() % 3) {
+        case 0: f << "acc " << (rng() % 2 ? "+" : "-") << rng() % 50 << "\n"; break;
+        case 1: f << "nop +" << rng() % 10 << "\n"; break;
+        default: f << "jmp +" << std::min<u64>(rng() % 4 + 1, size - 1 - i) << "\n"; break;
+        }
+    }
+    f << "jmp -" << (size - 1) << "\n";
+}
+
+// Message rules nested size levels deep: rule 42 matches size letters ending in 'a' and rule 31 size letters ending
+// in 'b', each through a chain of size disjunctions, followed by messages of 2 to 6 such words
+void generateDay19(std::ofstream& f, size_t size, std::mt19937_64& rng) {
+    f << "0: 8 11\n8: 42\n11: 42 31\n1: \"a\"\n2: \"b\"\n";
+    const size_t first42 = 100;
+    const size_t first31 = first42 + size;
+    f << "42: " << first42 << "\n31: " << first31 << "\n";
+    for (size_t first : { first42, first31 }) {
+        for (size_t level = 0; level + 1 < size; level++) {
+            size_t rule = first + level;
+            f << rule << ": 1 " << rule + 1 << " | 2 " << rule + 1 << "\n";
+        }
+        f << first + size - 1 << ": " << ((first == first42) ? 1 : 2) << "\n";
+    }
+    f << "\n";
+    static constexpr size_t kMessages = 100;
+    for (size_t i = 0; i < kMessages; i++) {
+        size_t words = rng() % 5 + 2;
+        for (size_t w = 0; w < words; w++) {
+            for (size_t c = 0; c + 1 < size; c++) {
+                f << ((rng() % 2) ? 'a' : 'b');
+            }
+            f << ((w + 1 < words && rng() % 4 != 0) ? 'a' : 'b');
+        }
+        f << "\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // sweep [directory with the day executables]
+    namespace fs = std::filesystem;
+    const fs::path binDir = (argc >= 2) ? fs::path{ argv[1] } : fs::absolute(argv[0]).parent_path();
+    const fs::path workDir = fs::absolute("sweep_work");
+
+    const std::vector<size_t> lineSizes{ 1'000, 4'000, 16'000, 64'000, 256'000, 1'024'000 };
+    const std::vector<size_t> depthSizes{ 4, 8, 16, 32, 64, 128 };
+    const std::vector<Day> days{
+        { "day01", generateDay01, lineSizes },
+        { "day02", generateDay02, lineSizes },
+        { "day03", generateDay03, lineSizes },
+        { "day04", generateDay04, lineSizes },
+        { "day05", generateDay05, lineSizes },
+        { "day06", generateDay06, lineSizes },
+        { "day07", generateDay07, lineSizes },
+        { "day08", generateDay08, lineSizes },
+        { "day19", generateDay19, depthSizes },
+    };
+    std::vector<size_t> threadCounts{ 1 };
+    if (std::thread::hardware_concurrency() > 1) {
+        threadCounts.push_back(std::thread::hardware_concurrency());
+    }
+    static constexpr size_t kRuns = 3;
+
+#if defined(_WIN32)
+    const char* discardOutput = " > NUL";
+#else
+    const char* discardOutput = " > /dev/null";
+#endif
+
+    std::cout << "day,size,threads,seconds,exponent\n";
+    for (auto& day : days) {
+        fs::path exe = binDir / day.name;
+#if defined(_WIN32)
+        exe += ".exe";
+#endif
+        if (!fs::exists(exe)) {
+            std::cerr << exe.string() << " not found, skipping\n";
+            continue;
+        }
+        fs::create_directories(workDir / day.name);
+        // seconds[t][s] for threadCounts[t] and day.sizes[s]
+        std::vector<std::vector<double>> seconds(threadCounts.size(), std::vector<double>(day.sizes.size()));
+        for (size_t s = 0; s < day.sizes.size(); s++) {
+            const size_t size = day.sizes[s];
+            std::mt19937_64 rng{ size };
+            {
+                std::ofstream f{ workDir / day.name / "input.txt", std::ios::binary };
+                day.generate(f, size, rng);
+            }
+            // The day reads input.txt from its working directory
+            fs::current_path(workDir / day.name);
+            for (size_t t = 0; t < threadCounts.size(); t++) {
+#if defined(_WIN32)
+                _putenv_s("AOC_THREADS", std::to_string(threadCounts[t]).c_str());
+#else
+                setenv("AOC_THREADS", std::to_string(threadCounts[t]).c_str(), 1);
+#endif
+                // Best of several runs
+                double& best = seconds[t][s];
+                for (size_t run = 0; run < kRuns; run++) {
+                    auto start = std::chrono::steady_clock::now();
+                    int status = std::system(("\"" + exe.string() + "\"" + discardOutput).c_str());
+                    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                    if (status != 0) {
+                        std::cerr << day.name << " failed at size " << size << "\n";
+                    }
+                    best = (run == 0) ? elapsed.count() : std::min(best, elapsed.count());
+                }
+            }
+            fs::current_path(workDir.parent_path());
+        }
+
+        for (size_t t = 0; t < threadCounts.size(); t++) {
+            // Least-squares fit of log(seconds) = exponent * log(size) + c
+            double meanX = 0.0, meanY = 0.0;
+            for (size_t s = 0; s < day.sizes.size(); s++) {
+                meanX += std::log(static_cast<double>(day.sizes[s])) / day.sizes.size();
+                meanY += std::log(seconds[t][s]) / day.sizes.size();
+            }
+            double covariance = 0.0, variance = 0.0;
+            for (size_t s = 0; s < day.sizes.size(); s++) {
+                double dx = std::log(static_cast<double>(day.sizes[s])) - meanX;
+                covariance += dx * (std::log(seconds[t][s]) - meanY);
+                variance += dx * dx;
+            }
+            double exponent = covariance / variance;
+            for (size_t s = 0; s < day.sizes.size(); s++) {
+                std::cout << day.name << "," << day.sizes[s] << "," << threadCounts[t] << "," << seconds[t][s] << ","
+                    << exponent << "\n";
+            }
+        }
+    }
+    return 0;
+}